@@ -0,0 +1,277 @@
+#include "Benchmark.h"
+#include "Camera.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+using std::cout; using std::endl;
+#include <random>
+#include <sstream>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Inputs are cycled through with a mask, so this must be a power of two. 256 vectors and matrices stay in L1.
+static const int inputCount = 256;
+static const int warmupIterations = 1 << 14;
+static const int iterations = 1 << 16;
+static const int repetitions = 15;
+
+static const void* volatile escapeSink;
+
+/// <summary> Forces <paramref name="value"/> to be computed, without the compiler being able to see how it is used. </summary>
+template<class T>
+static inline void doNotOptimize(const T& value) {
+#if defined(_MSC_VER)
+	escapeSink = &value;
+	_ReadWriteBarrier();
+#else
+	asm volatile("" : : "r"(&value) : "memory");
+#endif
+}
+
+/// <summary> Reads the time stamp counter. These are reference cycles, not core cycles, and are 0 where unsupported. </summary>
+static inline unsigned long long readCycles() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+struct BenchmarkResult {
+	string name;
+	double nsMedian;
+	double nsMin;
+	double cyclesMedian;
+};
+
+/// <summary> The most error a tier documents for each function, or 0 where it documents none. </summary>
+struct AccuracyBounds {
+	double rsqrtUlp;
+	double sqrtUlp;
+	double sincosUlp;
+	/// <summary> Absolute error of sin over [-8192, 8192]. </summary>
+	double sincosWideAbs;
+};
+
+struct AccuracyResult {
+	string tier;
+	string function;
+	string range;
+	double maxUlp;
+	double maxAbs;
+	double ulpBound;
+	double absBound;
+
+	/// <summary> Whether the errors are within the documented bounds. </summary>
+	bool withinBounds() const {
+		return (ulpBound == 0 || maxUlp <= ulpBound) && (absBound == 0 || maxAbs <= absBound);
+	}
+};
+
+/// <summary> Times <paramref name="op"/>, which is called with an input index in [0, inputCount). </summary>
+template<class Op>
+static BenchmarkResult measure(const string& name, Op op) {
+	for (int i = 0; i < warmupIterations; ++i) {
+		op(i & (inputCount - 1));
+	}
+	std::vector<double> ns;
+	std::vector<double> cycles;
+	for (int r = 0; r < repetitions; ++r) {
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		const unsigned long long startCycles = readCycles();
+		for (int i = 0; i < iterations; ++i) {
+			op(i & (inputCount - 1));
+		}
+		const unsigned long long endCycles = readCycles();
+		const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+		ns.push_back(std::chrono::duration<double, std::nano>(end - start).count() / iterations);
+		cycles.push_back((double)(endCycles - startCycles) / iterations);
+	}
+	std::sort(ns.begin(), ns.end());
+	std::sort(cycles.begin(), cycles.end());
+	BenchmarkResult result = { name, ns[repetitions / 2], ns[0], cycles[repetitions / 2] };
+	return result;
+}
+
+/// <summary> The distance between <paramref name="value"/> and <paramref name="reference"/>, in units of the reference's last place. </summary>
+static double ulpDistance(const float& value, const double& reference) {
+	const float rounded = (float)std::fabs(reference);
+	const double ulp = (double)std::nextafter(rounded, INFINITY) - rounded;
+	return std::fabs(value - reference) / ulp;
+}
+
+template<class Math>
+static void measureAccuracy(const string& tier, const AccuracyBounds& bounds, std::vector<AccuracyResult>& results) {
+	AccuracyResult rsqrt = { tier, "rsqrt", "[1e-6, 1e6]", 0, 0, bounds.rsqrtUlp, 0 };
+	AccuracyResult sqrt = { tier, "sqrt", "[1e-6, 1e6]", 0, 0, bounds.sqrtUlp, 0 };
+	for (float x = 1e-6f; x < 1e6f; x *= 1.0001f) {
+		const double r = 1 / std::sqrt((double)x);
+		rsqrt.maxUlp = std::max(rsqrt.maxUlp, ulpDistance(Math::rsqrt(x), r));
+		rsqrt.maxAbs = std::max(rsqrt.maxAbs, std::fabs(Math::rsqrt(x) - r));
+		const double s = std::sqrt((double)x);
+		sqrt.maxUlp = std::max(sqrt.maxUlp, ulpDistance(Math::sqrt(x), s));
+		sqrt.maxAbs = std::max(sqrt.maxAbs, std::fabs(Math::sqrt(x) - s));
+	}
+	AccuracyResult sin = { tier, "sin", "[-pi, pi]", 0, 0, bounds.sincosUlp, 0 };
+	AccuracyResult cos = { tier, "cos", "[-pi, pi]", 0, 0, bounds.sincosUlp, 0 };
+	for (float x = (float)-M_PI; x <= (float)M_PI; x += 1e-5f) {
+		float s, c;
+		Math::sincos(x, s, c);
+		sin.maxUlp = std::max(sin.maxUlp, ulpDistance(s, std::sin((double)x)));
+		sin.maxAbs = std::max(sin.maxAbs, std::fabs(s - std::sin((double)x)));
+		cos.maxUlp = std::max(cos.maxUlp, ulpDistance(c, std::cos((double)x)));
+		cos.maxAbs = std::max(cos.maxAbs, std::fabs(c - std::cos((double)x)));
+	}
+	// Far from zero the absolute error is what matters, since the reduction dominates.
+	AccuracyResult sinWide = { tier, "sin", "[-8192, 8192]", 0, 0, 0, bounds.sincosWideAbs };
+	for (float x = -8192; x <= 8192; x += 1e-3f) {
+		float s, c;
+		Math::sincos(x, s, c);
+		sinWide.maxAbs = std::max(sinWide.maxAbs, std::fabs(s - std::sin((double)x)));
+		sinWide.maxUlp = std::max(sinWide.maxUlp, ulpDistance(s, std::sin((double)x)));
+	}
+	results.push_back(rsqrt);
+	results.push_back(sqrt);
+	results.push_back(sin);
+	results.push_back(cos);
+	results.push_back(sinWide);
+}
+
+int runBenchmarks(const string& outputPath) {
+	// A fixed seed keeps the inputs identical between runs and commits.
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> distribution(-10, 10);
+	std::vector<Vector> a, b;
+	std::vector<float> s;
+	std::vector<Matrix> m, n;
+	for (int i = 0; i < inputCount; ++i) {
+		a.push_back(Vector(distribution(random), distribution(random), distribution(random)));
+		b.push_back(Vector(distribution(random), distribution(random), distribution(random)));
+		s.push_back(distribution(random));
+		float arr[16];
+		for (int j = 0; j < 16; ++j) {
+			arr[j] = distribution(random);
+		}
+		m.push_back(Matrix(arr));
+		for (int j = 0; j < 16; ++j) {
+			arr[j] = distribution(random);
+		}
+		n.push_back(Matrix(arr));
+	}
+	const Vector up(0, 1, 0);
+	Camera camera;
+
+	std::vector<BenchmarkResult> results;
+	// The cost of the harness itself: index masking, a load and the barrier. Subtract it when comparing tiny ops.
+	results.push_back(measure("baseline", [&](int i) { doNotOptimize(a[i]); }));
+
+	results.push_back(measure("Vector::operator+", [&](int i) { doNotOptimize(a[i] + b[i]); }));
+	results.push_back(measure("Vector::operator+=", [&](int i) { Vector v = a[i]; v += b[i]; doNotOptimize(v); }));
+	results.push_back(measure("Vector::operator-", [&](int i) { doNotOptimize(a[i] - b[i]); }));
+	results.push_back(measure("Vector::operator-=", [&](int i) { Vector v = a[i]; v -= b[i]; doNotOptimize(v); }));
+	results.push_back(measure("Vector::operator&", [&](int i) { doNotOptimize(a[i] & b[i]); }));
+	results.push_back(measure("Vector::operator&=", [&](int i) { Vector v = a[i]; v &= b[i]; doNotOptimize(v); }));
+	results.push_back(measure("Vector::operator/(Vector)", [&](int i) { doNotOptimize(a[i] / b[i]); }));
+	results.push_back(measure("Vector::operator/=(Vector)", [&](int i) { Vector v = a[i]; v /= b[i]; doNotOptimize(v); }));
+	results.push_back(measure("Vector::operator*(float)", [&](int i) { doNotOptimize(a[i] * s[i]); }));
+	results.push_back(measure("Vector::operator*=(float)", [&](int i) { Vector v = a[i]; v *= s[i]; doNotOptimize(v); }));
+	results.push_back(measure("Vector::operator/(float)", [&](int i) { doNotOptimize(a[i] / s[i]); }));
+	results.push_back(measure("Vector::operator/=(float)", [&](int i) { Vector v = a[i]; v /= s[i]; doNotOptimize(v); }));
+	results.push_back(measure("Vector::operator*(Vector)", [&](int i) { doNotOptimize(a[i] * b[i]); }));
+	results.push_back(measure("Vector::operator%", [&](int i) { doNotOptimize(a[i] % b[i]); }));
+	results.push_back(measure("Vector::operator%=", [&](int i) { Vector v = a[i]; v %= b[i]; doNotOptimize(v); }));
+	results.push_back(measure("Vector::operator~", [&](int i) { doNotOptimize(~a[i]); }));
+	results.push_back(measure("Vector::normalized<PreciseMath>", [&](int i) { doNotOptimize(a[i].normalized<PreciseMath>()); }));
+	results.push_back(measure("Vector::normalized<FastMath>", [&](int i) { doNotOptimize(a[i].normalized<FastMath>()); }));
+	results.push_back(measure("Vector::operator-()", [&](int i) { doNotOptimize(-a[i]); }));
+	results.push_back(measure("Vector::operator[]", [&](int i) { doNotOptimize(a[i][i & 3]); }));
+	results.push_back(measure("Vector::operator==", [&](int i) { doNotOptimize(a[i] == b[i]); }));
+	results.push_back(measure("Vector::nearlyEquals", [&](int i) { doNotOptimize(a[i].nearlyEquals(b[i], 0.5f)); }));
+	results.push_back(measure("Vector::mag", [&](int i) { doNotOptimize(a[i].mag()); }));
+	results.push_back(measure("Vector::mag<FastMath>", [&](int i) { doNotOptimize(a[i].mag<FastMath>()); }));
+	results.push_back(measure("Vector::mag2", [&](int i) { doNotOptimize(a[i].mag2()); }));
+	results.push_back(measure("Vector::normalize", [&](int i) { Vector v = a[i]; v.normalize(); doNotOptimize(v); }));
+	results.push_back(measure("Vector::normalize<FastMath>", [&](int i) { Vector v = a[i]; v.normalize<FastMath>(); doNotOptimize(v); }));
+
+	results.push_back(measure("Matrix::operator*(Matrix)", [&](int i) { doNotOptimize(m[i] * n[i]); }));
+	results.push_back(measure("Matrix::operator*(Vector)", [&](int i) { doNotOptimize(m[i] * a[i]); }));
+	results.push_back(measure("Matrix::translate", [&](int i) { doNotOptimize(m[i].translate(s[i], s[i], s[i])); }));
+	results.push_back(measure("Matrix::scale", [&](int i) { doNotOptimize(m[i].scale(s[i], s[i], s[i])); }));
+	results.push_back(measure("Matrix::rotateX", [&](int i) { doNotOptimize(m[i].rotateX(s[i], true)); }));
+	results.push_back(measure("Matrix::rotateX<FastMath>", [&](int i) { doNotOptimize(m[i].rotateX<FastMath>(s[i], true)); }));
+	results.push_back(measure("Matrix::rotateXSC", [&](int i) { doNotOptimize(m[i].rotateXSC(s[i], s[i])); }));
+	results.push_back(measure("Matrix::rotateY", [&](int i) { doNotOptimize(m[i].rotateY(s[i], true)); }));
+	results.push_back(measure("Matrix::rotateY<FastMath>", [&](int i) { doNotOptimize(m[i].rotateY<FastMath>(s[i], true)); }));
+	results.push_back(measure("Matrix::rotateYSC", [&](int i) { doNotOptimize(m[i].rotateYSC(s[i], s[i])); }));
+	results.push_back(measure("Matrix::rotateZ", [&](int i) { doNotOptimize(m[i].rotateZ(s[i], true)); }));
+	results.push_back(measure("Matrix::rotateZ<FastMath>", [&](int i) { doNotOptimize(m[i].rotateZ<FastMath>(s[i], true)); }));
+	results.push_back(measure("Matrix::rotateZSC", [&](int i) { doNotOptimize(m[i].rotateZSC(s[i], s[i])); }));
+	results.push_back(measure("Matrix::rotate", [&](int i) { doNotOptimize(m[i].rotate(s[i], s[i], s[i], true)); }));
+	results.push_back(measure("Matrix::rotate<FastMath>", [&](int i) { doNotOptimize(m[i].rotate<FastMath>(s[i], s[i], s[i], true)); }));
+	results.push_back(measure("Matrix::rotateSC", [&](int i) { doNotOptimize(m[i].rotateSC(s[i], s[i], s[i], s[i], s[i], s[i])); }));
+
+	results.push_back(measure("Camera::lookAt", [&](int i) { doNotOptimize(camera.lookAt(a[i], b[i], up)); }));
+	results.push_back(measure("Camera::viewPoint", [&](int i) { doNotOptimize(camera.viewPoint(a[i], b[i], up)); }));
+	results.push_back(measure("Camera::frustum", [&](int i) { doNotOptimize(camera.frustum(-s[i], s[i], -1, 1, 0.1f, 250)); }));
+	results.push_back(measure("Camera::ortho", [&](int i) { doNotOptimize(camera.ortho(-s[i], s[i], -1, 1, 0.1f, 250)); }));
+
+	results.push_back(measure("PreciseMath::rsqrt", [&](int i) { doNotOptimize(PreciseMath::rsqrt(std::fabs(s[i]))); }));
+	results.push_back(measure("FastMath::rsqrt", [&](int i) { doNotOptimize(FastMath::rsqrt(std::fabs(s[i]))); }));
+	results.push_back(measure("PreciseMath::sincos", [&](int i) { float sin, cos; PreciseMath::sincos(s[i], sin, cos); doNotOptimize(sin); doNotOptimize(cos); }));
+	results.push_back(measure("FastMath::sincos", [&](int i) { float sin, cos; FastMath::sincos(s[i], sin, cos); doNotOptimize(sin); doNotOptimize(cos); }));
+
+	std::vector<AccuracyResult> accuracy;
+	// PreciseMath is only as accurate as the C runtime, so it is measured but not checked
+	const AccuracyBounds preciseBounds = { 0, 0, 0, 0 };
+	// As documented on FastMath
+	const AccuracyBounds fastBounds = { 4, 5, 1.5, 1e-7 };
+	measureAccuracy<PreciseMath>("PreciseMath", preciseBounds, accuracy);
+	measureAccuracy<FastMath>("FastMath", fastBounds, accuracy);
+
+	std::ostringstream json;
+	json << "{\n\"iterations\": " << iterations << ",\n\"repetitions\": " << repetitions << ",\n\"benchmarks\": [\n";
+	for (size_t i = 0; i < results.size(); ++i) {
+		char line[256];
+		snprintf(line, sizeof(line), "{\"name\": \"%s\", \"ns_per_op\": %.3f, \"ns_per_op_min\": %.3f, \"cycles_per_op\": %.2f}%s\n",
+			results[i].name.c_str(), results[i].nsMedian, results[i].nsMin, results[i].cyclesMedian, i + 1 < results.size() ? "," : "");
+		json << line;
+	}
+	json << "],\n\"accuracy\": [\n";
+	for (size_t i = 0; i < accuracy.size(); ++i) {
+		char line[256];
+		snprintf(line, sizeof(line), "{\"tier\": \"%s\", \"function\": \"%s\", \"range\": \"%s\", \"max_ulp\": %.2f, \"max_abs\": %.3g, \"within_bounds\": %s}%s\n",
+			accuracy[i].tier.c_str(), accuracy[i].function.c_str(), accuracy[i].range.c_str(), accuracy[i].maxUlp, accuracy[i].maxAbs,
+			accuracy[i].withinBounds() ? "true" : "false", i + 1 < accuracy.size() ? "," : "");
+		json << line;
+	}
+	json << "]\n}\n";
+
+	if (outputPath.empty()) {
+		cout << json.str();
+	}
+	else {
+		std::ofstream file(outputPath);
+		if (!file.is_open()) {
+			cout << "Unable to open benchmark output file at path: " << outputPath << endl;
+			return 1;
+		}
+		file << json.str();
+	}
+
+	// Reported on standard error, so standard output stays valid JSON
+	bool accurate = true;
+	for (size_t i = 0; i < accuracy.size(); ++i) {
+		if (!accuracy[i].withinBounds()) {
+			std::cerr << "Accuracy bound exceeded: " << accuracy[i].tier << "::" << accuracy[i].function << " over " << accuracy[i].range
+				<< ", max_ulp " << accuracy[i].maxUlp << ", max_abs " << accuracy[i].maxAbs << endl;
+			accurate = false;
+		}
+	}
+	return accurate ? 0 : 2;
+}
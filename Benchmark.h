@@ -0,0 +1,12 @@
+#pragma once
+#include <string>
+using std::string;
+
+/// <summary>
+/// Runs the micro-benchmarks for the Vector, Matrix and Camera math, plus an accuracy sweep of each math tier.
+/// Results are written as JSON, one benchmark per line, so runs from two commits can be diffed directly. A FastMath
+/// function whose error exceeds its documented bound fails the run.
+/// </summary>
+/// <param name="outputPath"> The file to write results to. Results go to standard output if this is empty. </param>
+/// <returns> Zero on success, 1 if the output file could not be written, 2 if a math tier exceeded its accuracy bounds. </returns>
+int runBenchmarks(const string& outputPath);
@@ -1,4 +1,5 @@
 #include "Collision.h"
+#include "Profiler.h"
 
 void checkCollision(Particle* a, Particle* b) {
 	if (static_cast<PhysicsSphere*>(a) != nullptr && static_cast<PhysicsSphere*>(b) != nullptr) {
@@ -7,13 +8,18 @@ void checkCollision(Particle* a, Particle* b) {
 }
 
 bool sphere_sphere(PhysicsSphere* a, PhysicsSphere* b) {
+	PROFILE_ZONE_BEGIN(narrowphase, "Narrowphase");
 	Vector separation = a->getLocation() - b->getLocation();
-	Vector normal = ~separation;
-	float overlap = a->getRadius() + b->getRadius() - separation.mag();
+	// One reciprocal square root gives both the normal and the distance.
+	const float inverseDistance = CollisionMath::rsqrt(separation.mag2());
+	Vector normal = separation * inverseDistance;
+	float overlap = a->getRadius() + b->getRadius() - separation.mag2() * inverseDistance;
+	PROFILE_ZONE_END(narrowphase);
 	return resolve(a, b, overlap, normal, b->getLocation() + normal * overlap);
 }
 
 bool resolve(Particle* a, Particle* b, float overlap, Vector normal, Vector contactPoint) {
+	PROFILE_ZONE("Solve");
 	if (overlap <= 0) {
 		return false;
 	}
@@ -1,6 +1,9 @@
 #pragma once
 #include "PhysicsSphere.h"
 
+/// <summary> The math tier used for contact normals and distances. Swap for PreciseMath to remove the ulp error. </summary>
+typedef FastMath CollisionMath;
+
 /// <summary> 
 /// Checks for collision between two particles, and handles that collisions appropriately.
 /// If the combination of particles does not have a resolution function defined, nothing happens.
@@ -1,11 +1,7 @@
 #include "Cube.h"
 
-unsigned short Cube::numVertices, * Cube::numTriangleVertices, Cube::numEdgeVertices;
-float* Cube::vertices, * Cube::colors, * Cube::edgeColors;
-unsigned short** Cube::triangles, * Cube::edges;
-unsigned int Cube::vertexColorBuffer, * Cube::trianglesBuffers, Cube::edgesBuffer, Cube::edgeColorsBuffer, Cube::facesVAO, Cube::edgesVAO;
-bool Cube::buffered = false, Cube::initialized = false;
-char Cube::maxLOD = 0;
+MeshHandle Cube::classMesh;
+bool Cube::initialized = false;
 
 Cube::Cube(const float& x, const float& y, const float& z, const float& sx, const float& sy, const float& sz, const float& rx, const float& ry, const float& rz) {
 	this->x = x;
@@ -20,12 +16,16 @@ Cube::Cube(const float& x, const float& y, const float& z, const float& sx, cons
 	this->currentLOD = 0;
 
 	if (!initialized) {
-		numVertices = 8;
-		trianglesBuffers = new unsigned int[maxLOD + 1];
-		numTriangleVertices = new unsigned short[maxLOD + 1];
-		numTriangleVertices[0] = 22;
-		numEdgeVertices = 24;
-		vertices = new float[numVertices * 3]{
+		classMesh = MeshRegistry::create();
+		mesh = classMesh;
+		MeshRegistry::Mesh& data = MeshRegistry::get(classMesh);
+		data.maxLOD = 0;
+		data.numVertices = 8;
+		data.numTriangleVertices = new unsigned int[data.maxLOD + 1];
+		data.numTriangleVertices[0] = 36;
+		data.numEdgeVertices = 24;
+		data.lodErrors = new float[data.maxLOD + 1]{ 0 };
+		data.vertices = new float[data.numVertices * 3]{
 			-0.5, -0.5, -0.5,
 			0.5, -0.5, -0.5,
 			-0.5, 0.5, -0.5,
@@ -35,7 +35,7 @@ Cube::Cube(const float& x, const float& y, const float& z, const float& sx, cons
 			-0.5, 0.5, 0.5,
 			0.5, 0.5, 0.5
 		};
-		colors = new float[numVertices * 4]{
+		data.colors = new float[data.numVertices * 4]{
 			0, 0, 0, 1, // black
 			1, 0, 0, 1, // red
 			0, 1, 0, 1, // green
@@ -45,7 +45,7 @@ Cube::Cube(const float& x, const float& y, const float& z, const float& sx, cons
 			0, 1, 1, 1, // cyan
 			1, 1, 1, 1 // white
 		};
-		edges = new unsigned short[numEdgeVertices] {
+		data.edges = new unsigned int[data.numEdgeVertices] {
 			0, 1,
 				1, 4,
 				4, 2,
@@ -59,7 +59,7 @@ Cube::Cube(const float& x, const float& y, const float& z, const float& sx, cons
 				2, 6,
 				4, 7
 		};
-		edgeColors = new float[numVertices * 4]{
+		data.edgeColors = new float[data.numVertices * 4]{
 			0, 0, 0, 1, // black
 			0, 0, 0, 1, // black
 			0, 0, 0, 1, // black
@@ -69,52 +69,19 @@ Cube::Cube(const float& x, const float& y, const float& z, const float& sx, cons
 			0, 0, 0, 1, // black
 			0, 0, 0, 1 // black
 		};
-		triangles = new unsigned short* [maxLOD + 1];
-		triangles[0] = new unsigned short[numTriangleVertices[0]] {
-			0, 1, 3, 5, // bottom
-				6, 7, // front
-				2, 4, // top
-				0, 1, // back
+		data.triangles = new unsigned int* [data.maxLOD + 1];
+		data.triangles[0] = new unsigned int[data.numTriangleVertices[0]] {
+			0, 1, 3, 3, 1, 5, // bottom
+				3, 5, 6, 6, 5, 7, // front
+				6, 7, 2, 2, 7, 4, // top
+				2, 4, 0, 0, 4, 1, // back
 				1, 4, 7, 1, 7, 5, // right
 				0, 3, 6, 0, 6, 2 // left
 		};
-		initialized = false;
+		// The faces are half a unit from the center
+		data.innerRadius = 0.5f;
+		optimizeMesh("Cube");
+		initialized = true;
 	}
+	mesh = classMesh;
 }
-
-void Cube::drawTriangles() {
-	glDrawElements(GL_TRIANGLE_STRIP, 10, GL_UNSIGNED_SHORT, (void*)0);
-	glDrawElements(GL_TRIANGLES, 12, GL_UNSIGNED_SHORT, (void*)20);
-}
-
-char& Cube::getMaxLOD() const { return maxLOD; }
-
-unsigned short& Cube::getNumVertices() const { return numVertices; }
-
-unsigned short*& Cube::getNumTriangleVertices() const { return numTriangleVertices; }
-
-unsigned short& Cube::getNumEdgeVertices() const { return numEdgeVertices; }
-
-float*& Cube::getVertices() const { return vertices; }
-
-float*& Cube::getColors() const { return colors; }
-
-float*& Cube::getEdgeColors() const { return edgeColors; }
-
-unsigned short**& Cube::getTriangles() const { return triangles; }
-
-unsigned short*& Cube::getEdges() const { return edges; }
-
-unsigned int& Cube::getVertexColorBuffer() const { return vertexColorBuffer; }
-
-unsigned int*& Cube::getTrianglesBuffers() const { return trianglesBuffers; }
-
-unsigned int& Cube::getEdgesBuffer() const { return edgesBuffer; }
-
-unsigned int& Cube::getEdgeColorsBuffer() const { return edgeColorsBuffer; }
-
-unsigned int& Cube::getFacesVAO() const { return facesVAO; }
-
-unsigned int& Cube::getEdgesVAO() const { return edgesVAO; }
-
-bool& Cube::getBuffered() const { return buffered; }
\ No newline at end of file
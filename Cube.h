@@ -15,47 +15,10 @@ public:
 	/// <param name="ry"> The y-rotation of this cube, in radians. </param>
 	/// <param name="rz"> The z-rotation of this cube, in radians. </param>
 	Cube(const float& x = 0, const float& y = 0, const float& z = 0, const float& sx = 0, const float& sy = 0, const float& sz = 0, const float& rx = 0, const float& ry = 0, const float& rz = 0);
-	
-	void drawTriangles() override;
 
 private:
-	static unsigned short numVertices, *numTriangleVertices, numEdgeVertices;
-	static float *vertices, *colors, *edgeColors;
-	static unsigned short **triangles, *edges;
-	static unsigned int vertexColorBuffer, *trianglesBuffers, edgesBuffer, edgeColorsBuffer, facesVAO, edgesVAO;
-	static bool buffered, initialized;
-	static char maxLOD;
-
-	char& getMaxLOD() const override;
-
-	unsigned short& getNumVertices() const override;
-
-	unsigned short*& getNumTriangleVertices() const override;
-
-	unsigned short& getNumEdgeVertices() const override;
-
-	float*& getVertices() const override;
-
-	float*& getColors() const override;
-
-	float*& getEdgeColors() const override;
-
-	unsigned short**& getTriangles() const override;
-
-	unsigned short*& getEdges() const override;
-
-	unsigned int& getVertexColorBuffer() const override;
-
-	unsigned int*& getTrianglesBuffers() const override;
-
-	unsigned int& getEdgesBuffer() const override;
-
-	unsigned int& getEdgeColorsBuffer() const override;
-
-	unsigned int& getFacesVAO() const override;
-
-	unsigned int& getEdgesVAO() const override;
-
-	bool& getBuffered() const override;
+	/// <summary> The mesh every cube draws. </summary>
+	static MeshHandle classMesh;
+	static bool initialized;
 };
 
@@ -0,0 +1,141 @@
+#include "DynamicBuffer.h"
+#include <stdexcept>
+
+DynamicBuffer::DynamicBuffer(const GLenum& target, const size_t& frameSize) : cursor(0) {
+	this->target = target;
+	this->frameSize = frameSize;
+	buffer = 0;
+	persistent = false;
+	mapped = nullptr;
+	region = 0;
+	regionUsed = false;
+	for (int i = 0; i < frameCount; ++i) {
+		fences[i] = nullptr;
+	}
+}
+
+DynamicBuffer::~DynamicBuffer() {
+	destroy();
+}
+
+void DynamicBuffer::create() {
+	// Keep every region's start aligned for any allocation alignment up to 256
+	frameSize = (frameSize + 255) & ~(size_t)255;
+	persistent = GLExtensions::bufferStorage != nullptr;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(target, buffer);
+	if (persistent) {
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		GLExtensions::bufferStorage(target, frameSize * frameCount, nullptr, flags);
+		mapped = (unsigned char*)glMapBufferRange(target, 0, frameSize * frameCount, flags);
+		if (mapped == nullptr) {
+			// Immutable storage cannot be respecified, so orphaning needs a buffer of its own
+			cout << "Unable to map buffer persistently, orphaning each frame instead" << endl;
+			glDeleteBuffers(1, &buffer);
+			glGenBuffers(1, &buffer);
+			glBindBuffer(target, buffer);
+			persistent = false;
+		}
+	}
+	if (!persistent) {
+		glBufferData(target, frameSize, nullptr, GL_STREAM_DRAW);
+	}
+	region = 0;
+	regionUsed = false;
+}
+
+void DynamicBuffer::destroy() {
+	for (int i = 0; i < frameCount; ++i) {
+		wait(fences[i]);
+	}
+	if (buffer != 0) {
+		if (mapped != nullptr) {
+			glBindBuffer(target, buffer);
+			glUnmapBuffer(target);
+		}
+		glDeleteBuffers(1, &buffer);
+	}
+	buffer = 0;
+	mapped = nullptr;
+}
+
+void DynamicBuffer::wait(GLsync& fence) {
+	if (fence == nullptr) {
+		return;
+	}
+	GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	while (result == GL_TIMEOUT_EXPIRED) {
+		result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+	}
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+void DynamicBuffer::reserve(const size_t& frameSize) {
+	if (frameSize > this->frameSize) {
+		destroy();
+		// Grow geometrically so a slowly rising demand does not reallocate every frame
+		this->frameSize = frameSize > this->frameSize * 2 ? frameSize : this->frameSize * 2;
+	}
+	if (buffer == 0) {
+		create();
+	}
+}
+
+void DynamicBuffer::beginFrame() {
+	if (buffer == 0) {
+		create();
+	}
+	if (persistent) {
+		// Fence the region written last frame. The fence comes after every command issued so far,
+		// which includes the draws that read it.
+		if (regionUsed) {
+			fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			region = (region + 1) % frameCount;
+		}
+		// This region was last used frameCount frames ago, so this normally returns immediately
+		wait(fences[region]);
+	}
+	else {
+		// Orphan the old storage. The driver hands back fresh memory while the GPU finishes with the old.
+		glBindBuffer(target, buffer);
+		glBufferData(target, frameSize, nullptr, GL_STREAM_DRAW);
+		mapped = (unsigned char*)glMapBufferRange(target, 0, frameSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if (mapped == nullptr) {
+			cout << "Unable to map buffer" << endl;
+			throw std::runtime_error("Unable to map buffer.");
+		}
+	}
+	cursor = 0;
+	regionUsed = true;
+}
+
+void* DynamicBuffer::allocate(const size_t& bytes, size_t& offset, const size_t& alignment) {
+	size_t start = cursor.load();
+	size_t aligned;
+	do {
+		aligned = (start + alignment - 1) & ~(alignment - 1);
+		if (aligned + bytes > frameSize) {
+			return nullptr;
+		}
+	} while (!cursor.compare_exchange_weak(start, aligned + bytes));
+	offset = region * frameSize + aligned;
+	return mapped + offset;
+}
+
+void DynamicBuffer::commit() {
+	// The persistent mapping is coherent, so writes are already visible
+	if (!persistent) {
+		glBindBuffer(target, buffer);
+		glUnmapBuffer(target);
+		mapped = nullptr;
+	}
+}
+
+unsigned int DynamicBuffer::getBuffer() const {
+	return buffer;
+}
+
+bool DynamicBuffer::isPersistent() const {
+	return persistent;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <atomic>
+#include "WebGLUtility.h"
+
+/// <summary>
+/// A buffer for data that is rewritten every frame, such as per-instance transforms.
+/// Where glBufferStorage is available the buffer is mapped once, persistently, and split into frameCount regions
+/// that are cycled through; a fence per region keeps the CPU from overwriting data the GPU is still reading.
+/// Otherwise each frame orphans the buffer and maps the fresh storage.
+/// Either way, writers copy straight into GL memory and the driver never has to make its own copy.
+///
+/// Per frame, on the GL thread: beginFrame(), then any thread may allocate() and write, then commit() before drawing.
+/// </summary>
+class DynamicBuffer {
+public:
+	/// <summary> The number of frames the CPU may run ahead of the GPU before beginFrame() waits. </summary>
+	static const int frameCount = 3;
+
+	/// <summary> DynamicBuffer constructor. No GL objects are created until the first reserve() or beginFrame(). </summary>
+	/// <param name="target"> The target to bind the buffer to while creating and mapping it, such as GL_ARRAY_BUFFER. </param>
+	/// <param name="frameSize"> The initial number of bytes available each frame. </param>
+	DynamicBuffer(const GLenum& target, const size_t& frameSize = 1 << 16);
+	/// <summary> Releases the buffer, see destroy(). </summary>
+	~DynamicBuffer();
+
+	/// <summary> Makes sure at least <paramref name="frameSize"/> bytes will be available each frame. GL thread only,
+	/// and only outside beginFrame()/commit(). Growing waits for the GPU to finish with the old storage. </summary>
+	void reserve(const size_t& frameSize);
+
+	/// <summary> Starts a frame: waits until the GPU is done with the next region and makes it writable. GL thread only. </summary>
+	void beginFrame();
+
+	/// <summary> Reserves space in this frame's region. Safe to call from any thread between beginFrame() and commit(). </summary>
+	/// <param name="bytes"> The number of bytes to reserve. </param>
+	/// <param name="offset"> Receives the byte offset of the space within the buffer object, for attribute pointers and draws. </param>
+	/// <param name="alignment"> The alignment of the returned space. Must be a power of two. </param>
+	/// <returns> Where to write the data, or nullptr if this frame's region is full. </returns>
+	void* allocate(const size_t& bytes, size_t& offset, const size_t& alignment = 16);
+
+	/// <summary> Makes everything written this frame visible to the GPU. GL thread only, after every writer is done. </summary>
+	void commit();
+
+	/// <summary> Returns the GL buffer object. It changes when reserve() grows the buffer. </summary>
+	unsigned int getBuffer() const;
+
+	/// <summary> Returns whether the buffer is persistently mapped, rather than orphaned each frame. </summary>
+	bool isPersistent() const;
+
+	/// <summary> Waits for every outstanding fence and deletes the buffer object. The next reserve() or beginFrame() creates
+	/// it again. Call it while the context is still current when the buffer outlives the context. GL thread only. </summary>
+	void destroy();
+
+private:
+	GLenum target;
+	unsigned int buffer;
+	size_t frameSize;
+	bool persistent;
+	/// <summary> The persistent mapping of all regions, or this frame's mapping when orphaning. </summary>
+	unsigned char* mapped;
+	/// <summary> The region being written this frame. Always 0 when orphaning. </summary>
+	int region;
+	/// <summary> Byte offset of the next allocation within the current region. </summary>
+	std::atomic<size_t> cursor;
+	GLsync fences[frameCount];
+	/// <summary> Whether the current region has been handed out since the buffer was created. </summary>
+	bool regionUsed;
+
+	/// <summary> Creates the buffer object and, when persistent, maps it. Orphans each frame instead if the mapping fails. </summary>
+	void create();
+	/// <summary> Blocks until <paramref name="fence"/> has signalled, then deletes it. </summary>
+	static void wait(GLsync& fence);
+
+	// The buffer, its mapping and its fences belong to one object
+	DynamicBuffer(const DynamicBuffer&);
+	DynamicBuffer& operator=(const DynamicBuffer&);
+};
@@ -0,0 +1,33 @@
+#include "FrameUniforms.h"
+#include <cstring>
+
+FrameUniforms::FrameUniforms() {
+	// Created on the first update, since there may not be a GL context yet
+	buffer = 0;
+	memset(values, 0, sizeof(values));
+}
+
+void FrameUniforms::update(const Camera& camera) {
+	update(camera.getProjection(), camera.getView());
+}
+
+void FrameUniforms::update(const Matrix& projection, const Matrix& view) {
+	float next[48];
+	memcpy(next, projection.getValues(), sizeof(float) * 16);
+	memcpy(next + 16, view.getValues(), sizeof(float) * 16);
+	memcpy(next + 32, (projection * view).getValues(), sizeof(float) * 16);
+
+	if (buffer == 0) {
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(values), next, GL_DYNAMIC_DRAW);
+		memcpy(values, next, sizeof(values));
+	}
+	else if (memcmp(values, next, sizeof(values)) != 0) {
+		glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(values), next);
+		memcpy(values, next, sizeof(values));
+	}
+
+	glBindBufferBase(GL_UNIFORM_BUFFER, frameUniformsBinding, buffer);
+}
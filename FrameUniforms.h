@@ -0,0 +1,27 @@
+#pragma once
+#include "Camera.h"
+#include "WebGLUtility.h"
+
+/// <summary>
+/// The per-frame uniform buffer shared by every program. Holds the std140 block
+///     layout(std140, row_major) uniform Frame { mat4 projection; mat4 view; mat4 viewProjection; };
+/// at binding point frameUniformsBinding. It is uploaded at most once per frame instead of once per draw.
+/// </summary>
+class FrameUniforms {
+public:
+	FrameUniforms();
+
+	/// <summary> Uploads the camera's matrices, if they changed, and binds the block for drawing. </summary>
+	/// <param name="camera"> The camera to draw from. </param>
+	void update(const Camera& camera);
+
+	/// <summary> Uploads the matrices, if they changed, and binds the block for drawing. </summary>
+	/// <param name="projection"> The projection matrix. </param>
+	/// <param name="view"> The view matrix. </param>
+	void update(const Matrix& projection, const Matrix& view);
+
+private:
+	/// <summary> The block contents: projection, view and projection * view, each stored by row. </summary>
+	float values[48];
+	unsigned int buffer;
+};
@@ -0,0 +1,68 @@
+#include "Frustum.h"
+
+Frustum::Frustum(const Matrix& viewProjection) {
+	// Each plane is the fourth row plus or minus one of the others (Gribb and Hartmann),
+	// since a point is inside when -w <= x, y, z <= w in clip space.
+	for (int i = 0; i < 3; ++i) {
+		for (int j = 0; j < 4; ++j) {
+			planes[i * 2][j] = viewProjection.getValue(3, j) + viewProjection.getValue(i, j);
+			planes[i * 2 + 1][j] = viewProjection.getValue(3, j) - viewProjection.getValue(i, j);
+		}
+	}
+	for (int i = 0; i < 6; ++i) {
+		const float length = sqrtf(planes[i][0] * planes[i][0] + planes[i][1] * planes[i][1] + planes[i][2] * planes[i][2]);
+		for (int j = 0; j < 4; ++j) {
+			planes[i][j] /= length;
+		}
+	}
+}
+
+bool Frustum::intersectsSphere(const float& x, const float& y, const float& z, const float& radius) const {
+	for (int i = 0; i < 6; ++i) {
+		if (planes[i][0] * x + planes[i][1] * y + planes[i][2] * z + planes[i][3] < -radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int Frustum::cullSpheres(const float* x, const float* y, const float* z, const float* radius, const int& count, int* visible) const {
+	int visibleCount = 0;
+	int i = 0;
+#ifdef MATH_POLICY_SSE
+	__m128 a[6], b[6], c[6], d[6];
+	for (int p = 0; p < 6; ++p) {
+		a[p] = _mm_set1_ps(planes[p][0]);
+		b[p] = _mm_set1_ps(planes[p][1]);
+		c[p] = _mm_set1_ps(planes[p][2]);
+		d[p] = _mm_set1_ps(planes[p][3]);
+	}
+	for (; i + 4 <= count; i += 4) {
+		const __m128 px = _mm_loadu_ps(x + i);
+		const __m128 py = _mm_loadu_ps(y + i);
+		const __m128 pz = _mm_loadu_ps(z + i);
+		const __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (int p = 0; p < 6; ++p) {
+			const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[p], px), _mm_mul_ps(b[p], py)), _mm_add_ps(_mm_mul_ps(c[p], pz), d[p]));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+		}
+		// Write every index and only advance past the visible ones, so there is no branch per sphere
+		const int mask = _mm_movemask_ps(inside);
+		for (int j = 0; j < 4; ++j) {
+			visible[visibleCount] = i + j;
+			visibleCount += (mask >> j) & 1;
+		}
+	}
+#endif
+	for (; i < count; ++i) {
+		if (intersectsSphere(x[i], y[i], z[i], radius[i])) {
+			visible[visibleCount++] = i;
+		}
+	}
+	return visibleCount;
+}
+
+const float* Frustum::getPlane(const int& i) const {
+	return planes[i];
+}
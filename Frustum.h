@@ -0,0 +1,35 @@
+#pragma once
+#include "Matrix.h"
+
+/// <summary> The six clipping planes of a camera, used to skip objects that cannot be on screen. </summary>
+class Frustum {
+public:
+	Frustum() = default;
+	/// <summary> Extracts the planes of <paramref name="viewProjection"/>, which is projection * view. </summary>
+	/// <param name="viewProjection"> The combined projection and view matrix. </param>
+	Frustum(const Matrix& viewProjection);
+
+	/// <summary> Checks whether a sphere is at least partly inside the frustum. </summary>
+	/// <param name="x"> The x-coord of the sphere's center. </param>
+	/// <param name="y"> The y-coord of the sphere's center. </param>
+	/// <param name="z"> The z-coord of the sphere's center. </param>
+	/// <param name="radius"> The radius of the sphere. </param>
+	bool intersectsSphere(const float& x, const float& y, const float& z, const float& radius) const;
+
+	/// <summary> Tests many spheres at once, four at a time with SSE where available. </summary>
+	/// <param name="x"> The x-coords of the sphere centers. </param>
+	/// <param name="y"> The y-coords of the sphere centers. </param>
+	/// <param name="z"> The z-coords of the sphere centers. </param>
+	/// <param name="radius"> The radii of the spheres. </param>
+	/// <param name="count"> The number of spheres. </param>
+	/// <param name="visible"> Receives the indices of the spheres that intersect the frustum, in order. Must hold <paramref name="count"/> values. </param>
+	/// <returns> The number of visible spheres. </returns>
+	int cullSpheres(const float* x, const float* y, const float* z, const float* radius, const int& count, int* visible) const;
+
+	/// <summary> Gets a plane as (a, b, c, d), with a unit normal pointing into the frustum. </summary>
+	/// <param name="i"> The plane: left, right, bottom, top, near, far. </param>
+	const float* getPlane(const int& i) const;
+
+private:
+	float planes[6][4] = {};
+};
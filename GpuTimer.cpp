@@ -0,0 +1,152 @@
+#include "GpuTimer.h"
+#include "Profiler.h"
+#include "WebGLUtility.h"
+
+GpuTimer::GpuTimer() {
+	for (int i = 0; i < frameLatency; ++i) {
+		frames[i].usedQueries = 0;
+		frames[i].pending = false;
+	}
+	current = -1;
+	frameCount = 0;
+	lane = -1;
+	calibrationTicks = 0;
+	calibrationGpuTime = 0;
+	calibrationFrame = -1;
+	frameMilliseconds = -1;
+	droppedFrames = 0;
+}
+
+GpuTimer::~GpuTimer() {
+	release();
+}
+
+void GpuTimer::release() {
+	for (int i = 0; i < frameLatency; ++i) {
+		if (!frames[i].queries.empty()) {
+			glDeleteQueries((GLsizei)frames[i].queries.size(), frames[i].queries.data());
+		}
+		frames[i].queries.clear();
+		frames[i].usedQueries = 0;
+		frames[i].zones.clear();
+		frames[i].pending = false;
+	}
+	current = -1;
+	open.clear();
+}
+
+void GpuTimer::beginFrame() {
+	endFrame();
+
+	// Oldest first. Timestamps complete in order, so once a frame is not ready, no later one is either.
+	for (int age = frameLatency; age >= 1; --age) {
+		if (frameCount < (unsigned long long)age) {
+			continue;
+		}
+		Frame& frame = frames[(frameCount - age) % frameLatency];
+		if (frame.pending && !readBack(frame)) {
+			break;
+		}
+	}
+	// The oldest frame's queries are about to be reused
+	Frame& frame = frames[frameCount % frameLatency];
+	if (frame.pending) {
+		// Waiting would stall the CPU until the GPU catches up, which is what the timer is meant to find
+		frame.pending = false;
+		++droppedFrames;
+	}
+
+	current = (int)(frameCount % frameLatency);
+	++frameCount;
+	frame.usedQueries = 0;
+	frame.zones.clear();
+	// Both clocks together, so GPU times can be placed on the Profiler's timeline. Reading the GPU clock may wait for
+	// the GPU, so it is only done now and then; the clocks drift apart by far less than a zone in between.
+	if (Profiler::enabled && (calibrationFrame < 0 || (long long)frameCount - calibrationFrame >= calibrationFrames)) {
+		GLint64 gpuTime = 0;
+		glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+		calibrationGpuTime = gpuTime;
+		calibrationTicks = Profiler::now();
+		calibrationFrame = (long long)frameCount;
+	}
+	begin("GPU frame");
+}
+
+void GpuTimer::begin(const char* name) {
+	if (current < 0) {
+		return;
+	}
+	Frame& frame = frames[current];
+	Zone zone;
+	zone.name = name;
+	zone.startQuery = stamp();
+	zone.endQuery = -1;
+	open.push_back((int)frame.zones.size());
+	frame.zones.push_back(zone);
+}
+
+void GpuTimer::end() {
+	if (current < 0 || open.empty()) {
+		return;
+	}
+	frames[current].zones[open.back()].endQuery = stamp();
+	open.pop_back();
+}
+
+void GpuTimer::endFrame() {
+	if (current < 0) {
+		return;
+	}
+	while (!open.empty()) {
+		end();
+	}
+	frames[current].pending = true;
+	current = -1;
+}
+
+float GpuTimer::getFrameMilliseconds() const {
+	return frameMilliseconds;
+}
+
+int GpuTimer::getDroppedFrames() const {
+	return droppedFrames;
+}
+
+int GpuTimer::stamp() {
+	Frame& frame = frames[current];
+	if (frame.usedQueries == (int)frame.queries.size()) {
+		unsigned int query;
+		glGenQueries(1, &query);
+		frame.queries.push_back(query);
+	}
+	glQueryCounter(frame.queries[frame.usedQueries], GL_TIMESTAMP);
+	return frame.usedQueries++;
+}
+
+bool GpuTimer::readBack(Frame& frame) {
+	// The last timestamp written is the last to complete
+	GLint available = GL_FALSE;
+	glGetQueryObjectiv(frame.queries[frame.usedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (available == GL_FALSE) {
+		return false;
+	}
+	frame.pending = false;
+	if (Profiler::enabled && lane < 0) {
+		lane = Profiler::addLane("GPU");
+	}
+	for (size_t i = 0; i < frame.zones.size(); ++i) {
+		GLuint64 start = 0, end = 0;
+		glGetQueryObjectui64v(frame.queries[frame.zones[i].startQuery], GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(frame.queries[frame.zones[i].endQuery], GL_QUERY_RESULT, &end);
+		// The first zone is the whole frame
+		if (i == 0) {
+			frameMilliseconds = (float)((end - start) / 1e6);
+		}
+		if (Profiler::enabled && calibrationFrame >= 0) {
+			const long long startTicks = calibrationTicks + Profiler::toTicks(((long long)start - calibrationGpuTime) / 1e3);
+			const long long endTicks = calibrationTicks + Profiler::toTicks(((long long)end - calibrationGpuTime) / 1e3);
+			Profiler::record(lane, frame.zones[i].name, startTicks, endTicks);
+		}
+	}
+	return true;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <vector>
+
+/// <summary>
+/// Times zones of GL commands on the GPU with timestamp queries, to tell a frame that is slow to submit from one that is
+/// slow to draw.
+///
+/// Each frame's queries are read back by a later beginFrame(), and only once the GPU has written them, so timing never
+/// stalls the pipeline. The GPU clock is only read directly, which may wait for the GPU, every calibrationFrames frames
+/// while the Profiler is enabled. A frame whose results have still not arrived when its queries are needed
+/// again is dropped rather than waited for. Results are kept as getFrameMilliseconds(), and recorded in the Profiler on
+/// a "GPU" lane when it is enabled, placed on the same timeline as the CPU zones.
+///
+/// Timestamps mark when the GPU reaches a point in the command stream, so zones of work that overlaps on the GPU show
+/// roughly where the time went rather than exactly.
+///
+/// Per frame: beginFrame(), then begin() and end() around each zone, which may nest, then endFrame(). Queries are made
+/// as zones first need them, so a GpuTimer can be constructed before there is a GL context.
+/// </summary>
+class GpuTimer {
+public:
+	/// <summary> How many frames of queries are in flight. </summary>
+	static const int frameLatency = 4;
+	/// <summary> How many frames pass between readings of the GPU clock against the Profiler's, which may wait for the GPU. </summary>
+	static const int calibrationFrames = 1000;
+
+	GpuTimer();
+	/// <summary> Deletes the queries, see release(). </summary>
+	~GpuTimer();
+
+	/// <summary> Reads back every earlier frame whose results have arrived, then starts timing a frame as the zone "GPU frame". </summary>
+	void beginFrame();
+	/// <summary> Starts a zone. Does nothing outside beginFrame() and endFrame(). </summary>
+	/// <param name="name"> The name of the zone. Must outlive the Profiler. </param>
+	void begin(const char* name);
+	/// <summary> Ends the zone begun most recently. </summary>
+	void end();
+	/// <summary> Ends every open zone and the frame. </summary>
+	void endFrame();
+
+	/// <summary> Returns how long the GPU took over the most recent frame read back, in milliseconds, or -1 before the first. </summary>
+	float getFrameMilliseconds() const;
+	/// <summary> Returns how many frames were dropped because their results had not arrived in time. </summary>
+	int getDroppedFrames() const;
+
+	/// <summary> Deletes the queries, dropping any frames not read back. Call it while the context is still current when
+	/// the timer outlives the context. The next frame makes new queries. </summary>
+	void release();
+
+private:
+	struct Zone {
+		const char* name;
+		/// <summary> Indices into the frame's queries. </summary>
+		int startQuery, endQuery;
+	};
+
+	struct Frame {
+		/// <summary> Query objects, kept from frame to frame and added as zones need them. </summary>
+		std::vector<unsigned int> queries;
+		int usedQueries;
+		std::vector<Zone> zones;
+		/// <summary> Whether the frame's results are waiting to be read. </summary>
+		bool pending;
+	};
+
+	Frame frames[frameLatency];
+	/// <summary> The frame being timed, or -1 outside beginFrame() and endFrame(). </summary>
+	int current;
+	/// <summary> How many frames have begun. </summary>
+	unsigned long long frameCount;
+	/// <summary> Zones of the current frame not yet ended, innermost last. </summary>
+	std::vector<int> open;
+	/// <summary> The Profiler lane, or -1 until a result is first recorded. </summary>
+	int lane;
+	/// <summary> The Profiler time and GPU time, in nanoseconds, read together to place GPU times on the Profiler's timeline. </summary>
+	long long calibrationTicks, calibrationGpuTime;
+	/// <summary> The frameCount the clocks were last read at, or -1 before the first reading. </summary>
+	long long calibrationFrame;
+	float frameMilliseconds;
+	int droppedFrames;
+
+	/// <summary> Writes a timestamp into the next free query of the current frame. </summary>
+	/// <returns> The query's index in the frame. </returns>
+	int stamp();
+	/// <summary> Records a pending frame's zones if the GPU has written them all. </summary>
+	/// <returns> Whether the frame was read. </returns>
+	bool readBack(Frame& frame);
+
+	// The queries belong to one object
+	GpuTimer(const GpuTimer&);
+	GpuTimer& operator=(const GpuTimer&);
+};
@@ -1,7 +1,20 @@
 #include "GraphicsShape.h"
-
-unsigned int GraphicsShape::program;
+#include "MeshEdges.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "ResourceLoader.h"
+#include <cstring>
+#include <stdexcept>
+
+ShaderProgram GraphicsShape::program;
+ShaderProgram GraphicsShape::wireProgram;
+MeshRegistry::VertexLayout GraphicsShape::vertexLayout = MeshRegistry::QUANTIZED;
+GraphicsShape::EdgeMode GraphicsShape::edgeMode = GraphicsShape::BARYCENTRIC;
 bool GraphicsShape::programLoaded;
+PendingProgram GraphicsShape::pendingProgram;
+PendingProgram GraphicsShape::pendingWireProgram;
+bool GraphicsShape::programStarted;
+ResourceLoader* GraphicsShape::loader = nullptr;
 
 GraphicsShape::GraphicsShape() {
 	x = 0;
@@ -14,7 +27,10 @@ GraphicsShape::GraphicsShape() {
 	ry = 0;
 	rz = 0;
 	wire = false;
-	programLoaded = false;
+	color[0] = 1;
+	color[1] = 1;
+	color[2] = 1;
+	color[3] = 1;
 }
 
 Vector GraphicsShape::getLocation() const {
@@ -70,139 +86,539 @@ Matrix GraphicsShape::getModel() const {
 	return model;
 }
 
-void GraphicsShape::buffer() {
-	float* verticesColor = new float[getNumVertices() * 7];
-	for (int i = 0; i < getNumVertices(); ++i) {
-		verticesColor[i * 7] = getVertices()[i * 3];
-		verticesColor[i * 7 + 1] = getVertices()[i * 3 + 1];
-		verticesColor[i * 7 + 2] = getVertices()[i * 3 + 2];
-		verticesColor[i * 7 + 3] = getColors()[i * 4];
-		verticesColor[i * 7 + 4] = getColors()[i * 4 + 1];
-		verticesColor[i * 7 + 5] = getColors()[i * 4 + 2];
-		verticesColor[i * 7 + 6] = getColors()[i * 4 + 3];
+void GraphicsShape::setColor(const float& r, const float& g, const float& b, const float& a) {
+	color[0] = r;
+	color[1] = g;
+	color[2] = b;
+	color[3] = a;
+}
+
+void GraphicsShape::measure(MeshRegistry::Mesh& mesh) {
+	// The bounding sphere must contain the mesh however it is rotated, so use the farthest vertex
+	float radiusSquared = 0;
+	for (unsigned int i = 0; i < mesh.numVertices; ++i) {
+		const float* vertex = mesh.vertices + i * 3;
+		const float lengthSquared = vertex[0] * vertex[0] + vertex[1] * vertex[1] + vertex[2] * vertex[2];
+		if (lengthSquared > radiusSquared) {
+			radiusSquared = lengthSquared;
+		}
 	}
+	mesh.radius = sqrtf(radiusSquared);
+}
 
-	glGenBuffers(1, &getVertexColorBuffer());
-	glBindBuffer(GL_ARRAY_BUFFER, getVertexColorBuffer());
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * getNumVertices() * 7, verticesColor, GL_STATIC_DRAW);
+void GraphicsShape::uploadBuffers(MeshRegistry::Mesh& mesh) {
+	// Packed meshes come with their radius
+	if (mesh.packedVertices == nullptr) {
+		measure(mesh);
+	}
 
-	for (int i = 0; i <= getMaxLOD(); ++i) {
-		glGenBuffers(1, &getTrianglesBuffers()[i]);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, getTrianglesBuffers()[i]);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short) * getNumTriangleVertices()[i], getTriangles()[i], GL_STATIC_DRAW);
+	// Interleave the vertex data in the chosen layout
+	const unsigned int stride = MeshRegistry::getVertexStride(mesh.layout);
+	glGenBuffers(1, &mesh.vertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer);
+	if (mesh.packedVertices != nullptr) {
+		glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)stride * mesh.numVertices, mesh.packedVertices, GL_STATIC_DRAW);
+	}
+	else {
+		unsigned char* vertexData = new unsigned char[stride * mesh.numVertices];
+		for (unsigned int i = 0; i < mesh.numVertices; ++i) {
+			packVertex(mesh, i, vertexData + stride * i);
+		}
+		glBufferData(GL_ARRAY_BUFFER, stride * mesh.numVertices, vertexData, GL_STATIC_DRAW);
+		delete[] vertexData;
 	}
 
-	glGenBuffers(1, &getEdgesBuffer());
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, getEdgesBuffer());
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short) * getNumEdgeVertices(), getEdges(), GL_STATIC_DRAW);
+	// Every level, then the edges, in one index buffer
+	mesh.indexSize = MeshRegistry::getIndexSize(mesh.numVertices);
+	mesh.indexType = mesh.indexSize == sizeof(unsigned short) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	mesh.firstIndex = new unsigned int[mesh.maxLOD + 1];
+	unsigned int totalIndices = 0;
+	for (int lod = 0; lod <= mesh.maxLOD; ++lod) {
+		mesh.firstIndex[lod] = totalIndices;
+		totalIndices += mesh.numTriangleVertices[lod];
+	}
+	mesh.firstEdgeIndex = totalIndices;
+	if (mesh.edges != nullptr) {
+		totalIndices += mesh.numEdgeVertices;
+	}
+	else {
+		mesh.numEdgeVertices = 0;
+	}
+	glGenBuffers(1, &mesh.indexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)totalIndices * mesh.indexSize, nullptr, GL_STATIC_DRAW);
+	for (int lod = 0; lod <= mesh.maxLOD; ++lod) {
+		if (mesh.packedTriangles != nullptr) {
+			glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, (GLintptr)mesh.firstIndex[lod] * mesh.indexSize,
+				(GLsizeiptr)mesh.numTriangleVertices[lod] * mesh.indexSize, mesh.packedTriangles[lod]);
+		}
+		else {
+			bufferIndices(mesh.triangles[lod], mesh.numTriangleVertices[lod], mesh.firstIndex[lod], mesh.indexSize);
+		}
+	}
+	bufferIndices(mesh.edges, mesh.numEdgeVertices, mesh.firstEdgeIndex, mesh.indexSize);
+	if (mesh.numEdgeVertices > 0) {
+		bufferEdgeMasks(mesh);
+	}
 
-	glGenBuffers(1, &getEdgeColorsBuffer());
-	glBindBuffer(GL_ARRAY_BUFFER, getEdgeColorsBuffer());
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * getNumEdgeVertices() * 4, getEdgeColors(), GL_STATIC_DRAW);
+	// Edge colors are per vertex, read through the same indices as the positions
+	const unsigned int edgeColorCount = mesh.edgeColors != nullptr ? mesh.numVertices : 0;
+	glGenBuffers(1, &mesh.edgeColorsBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.edgeColorsBuffer);
+	if (mesh.layout == MeshRegistry::FULL_PRECISION) {
+		glBufferData(GL_ARRAY_BUFFER, sizeof(float) * edgeColorCount * 4, mesh.edgeColors, GL_STATIC_DRAW);
+	}
+	else {
+		unsigned char* edgeColors = new unsigned char[edgeColorCount * 4];
+		for (unsigned int i = 0; i < edgeColorCount * 4; ++i) {
+			edgeColors[i] = packUnorm8(mesh.edgeColors[i]);
+		}
+		glBufferData(GL_ARRAY_BUFFER, edgeColorCount * 4, edgeColors, GL_STATIC_DRAW);
+		delete[] edgeColors;
+	}
+}
 
-	// Set up shader attributes
-	unsigned int attribShapeLocation = glGetAttribLocation(program, "shapeLocation");
-	unsigned int attribShapeColor = glGetAttribLocation(program, "shapeColor");
+void GraphicsShape::bufferEdgeMasks(MeshRegistry::Mesh& mesh) {
+	// One mask per triangle of every level, in index buffer order, so a level's masks start at its first index / 3
+	const unsigned int totalIndices = mesh.firstEdgeIndex;
+	unsigned char* masks = new unsigned char[totalIndices / 3];
+	unsigned int* widened = nullptr;
+	for (int lod = 0; lod <= mesh.maxLOD; ++lod) {
+		const unsigned int count = mesh.numTriangleVertices[lod];
+		const unsigned int* indices = mesh.triangles != nullptr ? mesh.triangles[lod] : nullptr;
+		if (indices == nullptr) {
+			// Packed indices are at the uploaded width
+			delete[] widened;
+			widened = new unsigned int[count];
+			for (unsigned int i = 0; i < count; ++i) {
+				widened[i] = mesh.indexSize == sizeof(unsigned short) ? ((const unsigned short*)mesh.packedTriangles[lod])[i]
+					: ((const unsigned int*)mesh.packedTriangles[lod])[i];
+			}
+			indices = widened;
+		}
+		computeEdgeMasks(masks + mesh.firstIndex[lod] / 3, indices, count, mesh.edges, mesh.numEdgeVertices);
+	}
+	delete[] widened;
+
+	glGenBuffers(1, &mesh.edgeMaskBuffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, mesh.edgeMaskBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, totalIndices / 3, masks, GL_STATIC_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	delete[] masks;
+
+	glGenTextures(1, &mesh.edgeMaskTexture);
+	glBindTexture(GL_TEXTURE_BUFFER, mesh.edgeMaskTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_R8UI, mesh.edgeMaskBuffer);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
 
+void GraphicsShape::createVertexArrays(MeshRegistry::Mesh& mesh) {
 	// Set up for drawing faces
-	glGenVertexArrays(1, &getFacesVAO());
-	glBindVertexArray(getFacesVAO());
-
-	glBindBuffer(GL_ARRAY_BUFFER, getVertexColorBuffer());
-
-	// positions
-	glVertexAttribPointer(attribShapeLocation, 3, GL_FLOAT, false, 28, (void*)0);
-	glVertexAttribPointer(attribShapeColor, 4, GL_FLOAT, false, 28, (void*)12);
+	glGenVertexArrays(1, &mesh.facesVAO);
+	glBindVertexArray(mesh.facesVAO);
+
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer);
+	pointVertices(program, mesh.layout, true);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+
+	// Edge colors for the barycentric program, which every program is linked to find at the same location.
+	// Meshes without them leave the attribute off, which reads as opaque black.
+	if (mesh.edgeColors != nullptr && wireProgram.shapeEdgeColorAttribute >= 0) {
+		glBindBuffer(GL_ARRAY_BUFFER, mesh.edgeColorsBuffer);
+		pointEdgeColors(wireProgram.shapeEdgeColorAttribute, mesh.layout);
+	}
 
-	// colors
-	glEnableVertexAttribArray(attribShapeLocation);
-	glEnableVertexAttribArray(attribShapeColor);
+	// per-instance model matrix and color, pointed at the right offset before each draw
+	enableInstances(program);
 
 	glBindVertexArray(0);
 
 	// Set up for drawing edges
-	glGenVertexArrays(1, &getEdgesVAO());
-	glBindVertexArray(getEdgesVAO());
+	glGenVertexArrays(1, &mesh.edgesVAO);
+	glBindVertexArray(mesh.edgesVAO);
 
 	// positions
-	glBindBuffer(GL_ARRAY_BUFFER, getVertexColorBuffer());
-	glVertexAttribPointer(attribShapeLocation, 3, GL_FLOAT, false, 28, (void*)0);
-	glEnableVertexAttribArray(attribShapeLocation);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer);
+	pointVertices(program, mesh.layout, false);
 
 	// colors
-	glBindBuffer(GL_ARRAY_BUFFER, getEdgeColorsBuffer());
-	glVertexAttribPointer(attribShapeColor, 4, GL_FLOAT, false, 0, (void*)0);
-	glEnableVertexAttribArray(attribShapeColor);
+	if (mesh.edgeColors != nullptr) {
+		glBindBuffer(GL_ARRAY_BUFFER, mesh.edgeColorsBuffer);
+		pointEdgeColors(program.shapeColorAttribute, mesh.layout);
+	}
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, getEdgesBuffer());
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+
+	enableInstances(program);
 
 	glBindVertexArray(0);
+}
+
+void GraphicsShape::pointEdgeColors(const int& attribute, const MeshRegistry::VertexLayout& layout) {
+	if (layout == MeshRegistry::FULL_PRECISION) {
+		glVertexAttribPointer(attribute, 4, GL_FLOAT, false, 0, (void*)0);
+	}
+	else {
+		glVertexAttribPointer(attribute, 4, GL_UNSIGNED_BYTE, true, 0, (void*)0);
+	}
+	glEnableVertexAttribArray(attribute);
+}
+
+void GraphicsShape::extractEdges(const float& creaseAngle) {
+	MeshRegistry::Mesh& data = MeshRegistry::get(mesh);
+	const unsigned int count = data.numTriangleVertices[(int)data.maxLOD];
+	unsigned int* edges = new unsigned int[count * 2];
+	data.numEdgeVertices = ::extractEdges(edges, data.triangles[(int)data.maxLOD], count, data.vertices, creaseAngle);
+	delete[] data.edges;
+	data.edges = new unsigned int[data.numEdgeVertices];
+	std::copy(edges, edges + data.numEdgeVertices, data.edges);
+	delete[] edges;
+}
+
+void GraphicsShape::packVertex(const MeshRegistry::Mesh& mesh, const unsigned int& i, unsigned char* out) {
+	const float* position = mesh.vertices + i * 3;
+	const float* color = mesh.colors + i * 4;
+	if (mesh.layout == MeshRegistry::FULL_PRECISION) {
+		float* values = (float*)out;
+		for (int j = 0; j < 3; ++j) {
+			values[j] = position[j];
+		}
+		for (int j = 0; j < 4; ++j) {
+			values[3 + j] = color[j];
+		}
+		return;
+	}
+
+	// Positions are stored as fractions of the mesh radius; writeInstance() scales them back
+	const float scale = mesh.radius > 0 ? 1 / mesh.radius : 1;
+	short* quantized = (short*)out;
+	for (int j = 0; j < 3; ++j) {
+		quantized[j] = packSnorm16(position[j] * scale);
+	}
+	quantized[3] = 0;
+	unsigned char* colorOut = out + 8;
+	if (mesh.layout == MeshRegistry::QUANTIZED_NORMALS) {
+		// Shared vertices get the direction from the center, which is exact for spheres and smooth for everything else
+		const float length = sqrtf(position[0] * position[0] + position[1] * position[1] + position[2] * position[2]);
+		const float inverse = length > 0 ? 1 / length : 0;
+		const unsigned int normal = packNormal(position[0] * inverse, position[1] * inverse, position[2] * inverse);
+		memcpy(out + 8, &normal, sizeof(normal));
+		colorOut = out + 12;
+	}
+	for (int j = 0; j < 4; ++j) {
+		colorOut[j] = packUnorm8(color[j]);
+	}
+}
 
-	getBuffered() = true;
+void GraphicsShape::pointVertices(const ShaderProgram& program, const MeshRegistry::VertexLayout& layout, const bool& colors) {
+	const int stride = MeshRegistry::getVertexStride(layout);
+	if (layout == MeshRegistry::FULL_PRECISION) {
+		glVertexAttribPointer(program.shapeLocationAttribute, 3, GL_FLOAT, false, stride, (void*)0);
+	}
+	else {
+		glVertexAttribPointer(program.shapeLocationAttribute, 3, GL_SHORT, true, stride, (void*)0);
+	}
+	glEnableVertexAttribArray(program.shapeLocationAttribute);
+
+	// Shaders without lighting do not declare a normal, and it is left out
+	if (layout == MeshRegistry::QUANTIZED_NORMALS && program.shapeNormalAttribute >= 0) {
+		glVertexAttribPointer(program.shapeNormalAttribute, 4, GL_INT_2_10_10_10_REV, true, stride, (void*)8);
+		glEnableVertexAttribArray(program.shapeNormalAttribute);
+	}
 
-	delete[] verticesColor;
+	if (colors) {
+		if (layout == MeshRegistry::FULL_PRECISION) {
+			glVertexAttribPointer(program.shapeColorAttribute, 4, GL_FLOAT, false, stride, (void*)12);
+		}
+		else {
+			glVertexAttribPointer(program.shapeColorAttribute, 4, GL_UNSIGNED_BYTE, true, stride, (void*)(size_t)(stride - 4));
+		}
+		glEnableVertexAttribArray(program.shapeColorAttribute);
+	}
 }
 
-void GraphicsShape::drawEdges() {
-	glDrawElements(GL_LINES, getNumEdgeVertices(), GL_UNSIGNED_SHORT, (void*)0);
+short GraphicsShape::packSnorm16(const float& value) {
+	const float clamped = fmaxf(-1.0f, fminf(1.0f, value));
+	return (short)lrintf(clamped * 32767.0f);
 }
 
-void GraphicsShape::drawTriangles() {
-	glDrawElements(GL_TRIANGLE_STRIP, getNumTriangleVertices()[currentLOD], GL_UNSIGNED_SHORT, (void*)0);
+unsigned char GraphicsShape::packUnorm8(const float& value) {
+	const float clamped = fmaxf(0.0f, fminf(1.0f, value));
+	return (unsigned char)lrintf(clamped * 255.0f);
 }
 
-void GraphicsShape::render(const Matrix& projection, const Matrix& view) {
-	// Set up program
-	if (!programLoaded) {
-		program = createProgram("vertex.txt", "fragment.txt");
-		programLoaded = true;
+unsigned int GraphicsShape::packNormal(const float& x, const float& y, const float& z) {
+	// Three signed 10-bit components, lowest bits first, and a 2-bit w of 0
+	const float components[3] = { x, y, z };
+	unsigned int packed = 0;
+	for (int i = 0; i < 3; ++i) {
+		const int value = (int)lrintf(fmaxf(-1.0f, fminf(1.0f, components[i])) * 511.0f);
+		packed |= (unsigned int)(value & 0x3FF) << (i * 10);
 	}
+	return packed;
+}
 
-	// Set up buffers
-	if (!getBuffered()) {
-		buffer();
+void GraphicsShape::optimizeMesh(const string& name, const bool& overdraw) {
+	MeshRegistry::Mesh& data = MeshRegistry::get(mesh);
+	for (int lod = 0; lod <= data.maxLOD; ++lod) {
+		unsigned int* indices = data.triangles[lod];
+		const unsigned int count = data.numTriangleVertices[lod];
+		const float before = computeACMR(indices, count);
+		optimizeVertexCache(indices, count, data.numVertices);
+		if (overdraw) {
+			optimizeOverdraw(indices, count, data.vertices);
+		}
+		cout << name << " LOD " << lod << ": ACMR " << before << " -> " << computeACMR(indices, count) << endl;
 	}
 
-	// Determine Level of Detail
-	if (getMaxLOD() > 0) {
-		Vector position(x, y, z);
-		position = view * position;
-		currentLOD = (char)-100 / position.getZ();
-		if (currentLOD > getMaxLOD()) {
-			currentLOD = getMaxLOD();
+	// Coarse levels first, so each level's vertices stay at the front of the buffer. Edges only renumber.
+	const unsigned int lists = data.maxLOD + 2;
+	unsigned int** indexLists = new unsigned int*[lists];
+	unsigned int* counts = new unsigned int[lists];
+	for (int lod = 0; lod <= data.maxLOD; ++lod) {
+		indexLists[lod] = data.triangles[lod];
+		counts[lod] = data.numTriangleVertices[lod];
+	}
+	indexLists[lists - 1] = data.edges;
+	counts[lists - 1] = data.edges != nullptr ? data.numEdgeVertices : 0;
+	unsigned int* remap = new unsigned int[data.numVertices];
+	optimizeVertexFetch(remap, indexLists, counts, lists, data.numVertices);
+	remapVertices(data.vertices, 3, remap, data.numVertices);
+	remapVertices(data.colors, 4, remap, data.numVertices);
+	if (data.edgeColors != nullptr) {
+		remapVertices(data.edgeColors, 4, remap, data.numVertices);
+	}
+	delete[] remap;
+	delete[] counts;
+	delete[] indexLists;
+}
+
+void GraphicsShape::generateLODs(const float* ratios, const int& levels, const float& attributeWeight) {
+	MeshRegistry::Mesh& data = MeshRegistry::get(mesh);
+	if (data.maxLOD != 0) {
+		cout << "Shape already has levels of detail" << endl;
+		throw std::runtime_error("Shape already has levels of detail.");
+	}
+	unsigned int* original = data.triangles[0];
+	const unsigned int originalCount = data.numTriangleVertices[0];
+
+	// Attribute differences are squared against squared distances, so scale them to the size of the mesh
+	float radiusSquared = 0;
+	for (unsigned int i = 0; i < data.numVertices; ++i) {
+		const float* vertex = data.vertices + i * 3;
+		radiusSquared = fmaxf(radiusSquared, vertex[0] * vertex[0] + vertex[1] * vertex[1] + vertex[2] * vertex[2]);
+	}
+
+	delete[] data.triangles;
+	delete[] data.numTriangleVertices;
+	delete[] data.lodErrors;
+	data.maxLOD = (char)levels;
+	data.triangles = new unsigned int*[levels + 1];
+	data.numTriangleVertices = new unsigned int[levels + 1];
+	data.lodErrors = new float[levels + 1];
+	data.triangles[levels] = original;
+	data.numTriangleVertices[levels] = originalCount;
+	data.lodErrors[levels] = 0;
+
+	// Every level starts from the original, so its error is measured against the real surface
+	unsigned int* simplified = new unsigned int[originalCount];
+	for (int i = 0; i < levels; ++i) {
+		const int lod = levels - 1 - i;
+		const unsigned int target = (unsigned int)(originalCount / 3 * ratios[i]) * 3;
+		float error;
+		const unsigned int count = simplifyMesh(simplified, original, originalCount, data.vertices, data.numVertices, target, error,
+			data.colors, 4, attributeWeight * radiusSquared);
+		data.triangles[lod] = new unsigned int[count];
+		std::copy(simplified, simplified + count, data.triangles[lod]);
+		data.numTriangleVertices[lod] = count;
+		// A coarser level is never drawn in place of a finer one that claims a larger error
+		data.lodErrors[lod] = fmaxf(error, data.lodErrors[lod + 1]);
+	}
+	delete[] simplified;
+}
+
+void GraphicsShape::bufferIndices(const unsigned int* indices, const unsigned int& count, const unsigned int& first, const unsigned int& indexSize) {
+	if (count == 0) {
+		return;
+	}
+	if (indexSize == sizeof(unsigned int)) {
+		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, (GLintptr)first * indexSize, sizeof(unsigned int) * count, indices);
+		return;
+	}
+	// Every index fits in 16 bits, which halves the memory the GPU reads them from
+	unsigned short* narrow = new unsigned short[count];
+	for (unsigned int i = 0; i < count; ++i) {
+		narrow[i] = (unsigned short)indices[i];
+	}
+	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, (GLintptr)first * indexSize, sizeof(unsigned short) * count, narrow);
+	delete[] narrow;
+}
+
+void GraphicsShape::preload() {
+	if (programLoaded || programStarted) {
+		return;
+	}
+	pendingProgram = startProgram("vertex.txt", "fragment.txt");
+	try {
+		pendingWireProgram = startProgram("wireVertex.txt", "wireFragment.txt", "wireGeometry.txt");
+	}
+	catch (...) {
+		cout << "Drawing edges as lines instead." << endl;
+		edgeMode = LINES;
+	}
+	programStarted = true;
+}
+
+bool GraphicsShape::finishPrograms() {
+	if (programLoaded) {
+		return true;
+	}
+	if (!programStarted) {
+		// Nothing preloaded them, so build them now and wait
+		preload();
+	}
+	else if (!isProgramReady(pendingProgram) || (pendingWireProgram.id != 0 && !isProgramReady(pendingWireProgram))) {
+		return false;
+	}
+	program = finishShaderProgram(pendingProgram);
+	if (pendingWireProgram.id != 0) {
+		try {
+			wireProgram = finishShaderProgram(pendingWireProgram);
 		}
-		else if (currentLOD < 0) {
-			currentLOD = 0;
+		catch (...) {
+			cout << "Drawing edges as lines instead." << endl;
+			edgeMode = LINES;
 		}
 	}
+	programLoaded = true;
+	return true;
+}
 
-	glUseProgram(program);
+bool GraphicsShape::prepare() {
+	// Set up program
+	const bool programReady = finishPrograms();
 
-	unsigned int modelUniform = glGetUniformLocation(program, "model");
-	unsigned int projectionUniform = glGetUniformLocation(program, "projection");
-	unsigned int viewUniform = glGetUniformLocation(program, "view");
-	glUniformMatrix4fv(modelUniform, 1, true, getModel().getValues());
-	glUniformMatrix4fv(projectionUniform, 1, true, projection.getValues());
-	glUniformMatrix4fv(viewUniform, 1, true, view.getValues());
+	// Set up buffers, or have the loader start on them so they are ready in a later frame
+	MeshRegistry::Mesh& data = MeshRegistry::get(mesh);
+	if (!data.buffered) {
+		if (data.vertexBuffer == 0 && loader != nullptr) {
+			loader->load(mesh);
+		}
+		else if (data.vertexBuffer == 0) {
+			// Packed meshes come with their layout
+			if (data.packedVertices == nullptr) {
+				data.layout = vertexLayout;
+			}
+			uploadBuffers(data);
+		}
+		// VAOs are not shared with the loader's context, and point at the program's attribute locations
+		if (data.loading || !programReady) {
+			return false;
+		}
+		createVertexArrays(data);
+		data.buffered = true;
+	}
+	return programReady;
+}
 
-	// Bind everything for drawing faces, except the triangles element array
-	glBindVertexArray(getFacesVAO());
+void GraphicsShape::selectLOD(const float& pixelsPerUnit, const float& errorPixels, const float& hysteresis) {
+	const MeshRegistry::Mesh& data = MeshRegistry::get(mesh);
+	if (data.maxLOD == 0) {
+		return;
+	}
+	// Errors are in model units, and the largest scale factor stretches them the most
+	const float scale = fmaxf(fabsf(sx), fmaxf(fabsf(sy), fabsf(sz))) * pixelsPerUnit;
+	const float* errors = data.lodErrors;
+
+	// The coarsest level that is accurate enough, and the coarsest that is comfortably so
+	char required = data.maxLOD, relaxed = data.maxLOD;
+	for (int lod = data.maxLOD; lod >= 0; --lod) {
+		const float pixels = errors[lod] * scale;
+		if (pixels <= errorPixels) {
+			required = (char)lod;
+		}
+		if (pixels <= errorPixels * (1 - hysteresis)) {
+			relaxed = (char)lod;
+		}
+	}
+	if (currentLOD < required) {
+		currentLOD = required;
+	}
+	else if (currentLOD > relaxed) {
+		currentLOD = relaxed;
+	}
+}
 
-	// Bind the correct element array based on LOD
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, getTrianglesBuffers()[currentLOD]);
+void GraphicsShape::writeInstance(float* out) const {
+	// GL expects columns first, while Matrix is stored by row
+	const float* model = getModel().getValues();
+	for (int col = 0; col < 4; ++col) {
+		for (int row = 0; row < 4; ++row) {
+			out[col * 4 + row] = model[row * 4 + col];
+		}
+	}
+	// Quantized positions are fractions of the mesh radius, so fold the radius into the model's linear part
+	const MeshRegistry::Mesh& data = MeshRegistry::get(mesh);
+	if (data.layout != MeshRegistry::FULL_PRECISION) {
+		for (int i = 0; i < 12; ++i) {
+			out[i] *= data.radius;
+		}
+	}
+	out[16] = color[0];
+	out[17] = color[1];
+	out[18] = color[2];
+	out[19] = color[3];
+}
 
-	// Draw from triangles array
-	if (!wire) {
-		drawTriangles();
+void GraphicsShape::enableInstances(const ShaderProgram& program) {
+	// A mat4 attribute takes up four consecutive locations, one per column
+	for (int col = 0; col < 4; ++col) {
+		glVertexAttribDivisor(program.instanceModelAttribute + col, 1);
+		glEnableVertexAttribArray(program.instanceModelAttribute + col);
 	}
+	glVertexAttribDivisor(program.instanceColorAttribute, 1);
+	glEnableVertexAttribArray(program.instanceColorAttribute);
+}
 
-	// Bind everything for drawing edges
-	glBindVertexArray(getEdgesVAO());
+void GraphicsShape::bindInstances(const ShaderProgram& program, const size_t& offset) {
+	const int stride = sizeof(float) * instanceFloats;
+	for (int col = 0; col < 4; ++col) {
+		glVertexAttribPointer(program.instanceModelAttribute + col, 4, GL_FLOAT, false, stride, (void*)(offset + sizeof(float) * 4 * col));
+	}
+	glVertexAttribPointer(program.instanceColorAttribute, 4, GL_FLOAT, false, stride, (void*)(offset + sizeof(float) * 16));
+}
 
-	// Draw from edges array
-	drawEdges();
+void GraphicsShape::submit(RenderQueue& queue) {
+	if (queue.software != nullptr) {
+		// Drawn straight from the source data, so only the bounds are needed
+		MeshRegistry::Mesh& data = MeshRegistry::get(mesh);
+		if (!data.buffered && data.packedVertices == nullptr && data.radius == 0) {
+			measure(data);
+		}
+	}
+	else if (!prepare()) {
+		return;
+	}
+	queue.add(this);
+}
 
-	glBindVertexArray(0);
+float GraphicsShape::getBoundingRadius() const {
+	// Rotation does not change the sphere, but the largest scale factor stretches it
+	const float scale = fmaxf(fabsf(sx), fmaxf(fabsf(sy), fabsf(sz)));
+	return MeshRegistry::get(mesh).radius * scale;
+}
+
+float GraphicsShape::getOccluderRadius() const {
+	const float scale = fminf(fabsf(sx), fminf(fabsf(sy), fabsf(sz)));
+	return MeshRegistry::get(mesh).innerRadius * scale;
+}
 
-	glUseProgram(0);
-}
\ No newline at end of file
+MeshHandle GraphicsShape::getMesh() const {
+	return mesh;
+}
+
+void GraphicsShape::setMesh(const MeshHandle& mesh) {
+	this->mesh = mesh;
+	// The new mesh may have fewer levels
+	currentLOD = 0;
+}
@@ -1,18 +1,17 @@
 #pragma once
 #include <GLAD/glad.h>
-#include <GLFW/glfw3.h>
+#include "FrameUniforms.h"
 #include "Matrix.h"
+#include "MeshRegistry.h"
+#include "RenderQueue.h"
 #include "Vector.h"
 #include "WebGLUtility.h"
 
+class ResourceLoader;
+
 /// <summary> A high level graphics object for representing any arbitrary polygon.
 /// Intended to be inherited to create more specific geometries. </summary>
 class GraphicsShape {
-	//static unsigned short numVertices, numTriangleVertices, numEdgeVertices;
-	//static float *vertices, *colors, *edgeColors;
-	//static unsigned short *triangles, *edges;
-	//static unsigned int vertexColorBuffer, trianglesBuffer, edgesBuffer, edgeColorsBuffer, program, facesVAO, edgesVAO;
-	//static bool buffered, programLoaded;
 public:
 	/// <summary> The x position of this shape. Can be modified directly. </summary>
 	float x;
@@ -34,6 +33,8 @@ public:
 	float rz;
 	/// <summary> Whether this shape should render in wireframe only. Can be modified directly. </summary>
 	bool wire;
+	/// <summary> The RGBA color this shape's vertex colors are multiplied by. Can be modified directly. </summary>
+	float color[4];
 	/// <summary> Returns this shape's location as a vector. </summary>
 	Vector getLocation() const;
 	/// <summary> Set this shape's location. </summary>
@@ -66,60 +67,144 @@ public:
 	void setRotation(const float& xrotation, const float& yrotation, const float& zrotation);
 	/// <summary> Returns this shape's model matrix. This function computes a new matrix every time it is called. </summary>
 	Matrix getModel() const;
-	/// <summary> Buffers this shape's model data, as well as sets up the VAO for this shape. </summary>
-	virtual void buffer();
-	/// <summary> Renders this shape's edges, either for highlighting or wireframe purposes. </summary>
-	virtual void drawEdges();
-	/// <summary> Renders this shape's triangles. This is the main geometry of the shape. </summary>
-	virtual void drawTriangles();
-	/// <summary> The main render loop of this shape. Responsible for loading and setting up the relevant shaders,
-	/// binding and buffering data, and calling buffer(), drawEdges(), and drawTriangles(). </summary>
-	virtual void render(const Matrix&, const Matrix&);
+	/// <summary> Set the color this shape is tinted by. </summary>
+	/// <param name="r"> The red component. </param>
+	/// <param name="g"> The green component. </param>
+	/// <param name="b"> The blue component. </param>
+	/// <param name="a"> The alpha component. </param>
+	void setColor(const float& r, const float& g, const float& b, const float& a = 1);
+	/// <summary> Queues this shape on <paramref name="queue"/>. Culling, level of detail and the model matrix are
+	/// worked out when the queue is flushed, and only for shapes that turn out to be on screen.
+	/// The mesh is uploaded first, unless the queue draws with a SoftwareRasterizer. With a loader, or after preload(),
+	/// a shape whose mesh or programs are not ready yet is left out of the frame rather than waited for. </summary>
+	/// <param name="queue"> The queue to draw this shape with. </param>
+	void submit(RenderQueue& queue);
+	/// <summary> Returns the radius of a sphere around getLocation() that contains this shape at its current scale.
+	/// Only valid once the shape has been buffered. </summary>
+	float getBoundingRadius() const;
+	/// <summary> Returns the radius of a sphere around getLocation() that is entirely inside this shape at its current scale,
+	/// or 0 if this shape should never hide anything behind it. </summary>
+	float getOccluderRadius() const;
+
+	/// <summary> Returns the mesh this shape draws. </summary>
+	MeshHandle getMesh() const;
+	/// <summary> Set the mesh this shape draws. Shapes drawing the same mesh are drawn together. </summary>
+	/// <param name="mesh"> The new mesh of this shape. </param>
+	void setMesh(const MeshHandle& mesh);
+
+	/// <summary> The layout meshes uploaded from now on are stored in. Meshes already uploaded keep theirs.
+	/// Can be modified directly. </summary>
+	static MeshRegistry::VertexLayout vertexLayout;
+
+	/// <summary> When set, meshes are uploaded by it in the background the first time a shape drawing them is submitted,
+	/// and shapes are not drawn until theirs is ready. Null uploads on the spot. Can be modified directly. </summary>
+	static ResourceLoader* loader;
+
+	/// <summary> Starts building the programs shapes draw with, so the first frame with a shape in it does not wait for the
+	/// compiler. Where the driver compiles in parallel, shapes are left out of frames until the programs are ready;
+	/// elsewhere the first shape submitted finishes them. Does nothing once started. </summary>
+	static void preload();
+
+	/// <summary> How the edges of shapes are drawn. </summary>
+	enum EdgeMode {
+		/// <summary> In the same draw as the faces: a geometry shader gives each triangle barycentric coordinates, and the
+		/// fragment shader colors the pixels near the sides that are mesh edges. Wireframe shapes draw every level of detail. </summary>
+		BARYCENTRIC,
+		/// <summary> A second draw of the mesh's edge list as GL_LINES, at the finest level of detail. </summary>
+		LINES
+	};
+
+	/// <summary> How the edges of shapes are drawn. Falls back to LINES if the barycentric program cannot be built.
+	/// Can be modified directly. </summary>
+	static EdgeMode edgeMode;
+
+	/// <summary> The number of floats of per-instance data: a column-major model matrix followed by an RGBA color. </summary>
+	static const int instanceFloats = 20;
 
 protected:
 	char currentLOD = 0;
 
-	// The following block of getters exists so that each child of the GraphicsShape class may have separate static
-	// versions of these variables, without sharing those static variables with the parent or each other, but while still
-	// allowing GraphicsShape to provide inherited functions which use these variables.
-	
-	virtual char& getMaxLOD() const = 0;
-
-	virtual unsigned short& getNumVertices() const = 0;
-
-	virtual unsigned short*& getNumTriangleVertices() const = 0;
-
-	virtual unsigned short& getNumEdgeVertices() const = 0;
-
-	virtual float*& getVertices() const = 0;
-
-	virtual float*& getColors() const = 0;
+	/// <summary> The mesh this shape draws. Set by the constructor of each child. </summary>
+	MeshHandle mesh;
 
-	virtual float*& getEdgeColors() const = 0;
-	
-	virtual unsigned short**& getTriangles() const = 0;
+	/// <summary> Reorders the index lists of this shape's mesh for the vertex cache, then its vertices for fetch locality.
+	/// Call once the mesh data is generated and before it is uploaded. Prints the ACMR of each level before and after. </summary>
+	/// <param name="name"> The name of the shape, for the report. </param>
+	/// <param name="overdraw"> Whether to also sort triangle clusters to reduce overdraw. Convex shapes gain nothing from it. </param>
+	void optimizeMesh(const string& name, const bool& overdraw = false);
 
-	virtual unsigned short*& getEdges() const = 0;
+	/// <summary> Replaces the single level of detail of this shape's mesh with a chain simplified from it, and fills its errors.
+	/// The original triangles become the finest level, and every level shares the original vertices.
+	/// Call once the mesh data is generated and before optimizeMesh(). </summary>
+	/// <param name="ratios"> The fraction of the original triangles to keep at each coarser level, finest first. </param>
+	/// <param name="levels"> The number of ratios. </param>
+	/// <param name="attributeWeight"> How strongly vertex colors resist being merged, relative to moving the surface by the mesh radius. </param>
+	void generateLODs(const float* ratios, const int& levels, const float& attributeWeight = 0.01f);
 
-	virtual unsigned int& getVertexColorBuffer() const = 0;
+	/// <summary> Fills the edge list of this shape's mesh with the sides of its finest level where the faces meet at more than
+	/// <paramref name="creaseAngle"/>, for meshes that do not come with edges. Call before optimizeMesh(). </summary>
+	/// <param name="creaseAngle"> The smallest angle between face normals that makes an edge, in radians. </param>
+	void extractEdges(const float& creaseAngle);
 
-	virtual unsigned int*& getTrianglesBuffers() const = 0;
-
-	virtual unsigned int& getEdgesBuffer() const = 0;
-
-	virtual unsigned int& getEdgeColorsBuffer() const = 0;
-
-	virtual unsigned int& getFacesVAO() const = 0;
-
-	virtual unsigned int& getEdgesVAO() const = 0;
-
-	virtual bool& getBuffered() const = 0;
+	/// <summary> Writes vertex <paramref name="i"/> of <paramref name="mesh"/> in its layout to <paramref name="out"/>.
+	/// Needs the mesh radius for quantized layouts. </summary>
+	static void packVertex(const MeshRegistry::Mesh& mesh, const unsigned int& i, unsigned char* out);
 
 	// Constructor is protected to prevent instantiation.
 	/// <summary> Shape constructor. </summary>
 	GraphicsShape();
 
 private:
-	static unsigned int program;
+	friend class RenderQueue;
+	friend class ResourceLoader;
+
+	static ShaderProgram program;
+	/// <summary> Draws faces with their edges, or edges alone, in one pass. See BARYCENTRIC. </summary>
+	static ShaderProgram wireProgram;
 	static bool programLoaded;
-};
+	/// <summary> The programs between preload() and the first submit() that finds them ready. </summary>
+	static PendingProgram pendingProgram;
+	static PendingProgram pendingWireProgram;
+	static bool programStarted;
+
+	/// <summary> Sets the radius of <paramref name="mesh"/> from its vertices. </summary>
+	static void measure(MeshRegistry::Mesh& mesh);
+	/// <summary> Creates the buffers of <paramref name="mesh"/> and uploads its data in its layout, measuring it first
+	/// unless it was packed already. Makes no VAO and uses no program, so it can run on a ResourceLoader's context. </summary>
+	static void uploadBuffers(MeshRegistry::Mesh& mesh);
+	/// <summary> Uploads which sides of each triangle of <paramref name="mesh"/> are edges, for the barycentric program. </summary>
+	static void bufferEdgeMasks(MeshRegistry::Mesh& mesh);
+	/// <summary> Creates the VAOs for drawing the faces and edges of <paramref name="mesh"/> from its filled buffers. </summary>
+	static void createVertexArrays(MeshRegistry::Mesh& mesh);
+	/// <summary> Points the bound VAO's position, normal and, if <paramref name="colors"/>, color attributes into the bound array buffer. </summary>
+	static void pointVertices(const ShaderProgram& program, const MeshRegistry::VertexLayout& layout, const bool& colors);
+	/// <summary> Points <paramref name="attribute"/> of the bound VAO at the edge colors in the bound array buffer. </summary>
+	static void pointEdgeColors(const int& attribute, const MeshRegistry::VertexLayout& layout);
+	/// <summary> Maps [-1, 1] to a signed normalized 16-bit integer. </summary>
+	static short packSnorm16(const float& value);
+	/// <summary> Maps [0, 1] to an unsigned normalized 8-bit integer. </summary>
+	static unsigned char packUnorm8(const float& value);
+	/// <summary> Packs a unit vector as GL_INT_2_10_10_10_REV. </summary>
+	static unsigned int packNormal(const float& x, const float& y, const float& z);
+	/// <summary> Uploads indices into the bound element array buffer at <paramref name="first"/>, narrowed to <paramref name="indexSize"/> bytes each. </summary>
+	static void bufferIndices(const unsigned int* indices, const unsigned int& count, const unsigned int& first, const unsigned int& indexSize);
+	/// <summary> Finishes the programs if they are ready, or loads them if they were never started. </summary>
+	/// <returns> Whether the programs can be drawn with. </returns>
+	static bool finishPrograms();
+	/// <summary> Loads the programs and uploads this shape's mesh, if either has not been done yet. </summary>
+	/// <returns> Whether the shape can be drawn, which is only false while the programs or the mesh are loading. </returns>
+	bool prepare();
+	/// <summary> Chooses currentLOD as the coarsest level whose error on screen is within <paramref name="errorPixels"/>.
+	/// Once chosen, a level is kept until its error leaves the band between errorPixels * (1 - hysteresis) and errorPixels,
+	/// so a shape sitting on a boundary does not flicker between levels. </summary>
+	/// <param name="pixelsPerUnit"> How many pixels one world unit at this shape's distance covers. </param>
+	/// <param name="errorPixels"> The largest error allowed, in pixels. </param>
+	/// <param name="hysteresis"> The fraction of <paramref name="errorPixels"/> an error must fall below before a coarser level is chosen. </param>
+	void selectLOD(const float& pixelsPerUnit, const float& errorPixels, const float& hysteresis);
+	/// <summary> Writes this shape's per-instance data to <paramref name="out"/>, which must hold instanceFloats values. </summary>
+	void writeInstance(float* out) const;
+	/// <summary> Enables the instance attributes of <paramref name="program"/> on the bound VAO, one value per instance. </summary>
+	static void enableInstances(const ShaderProgram& program);
+	/// <summary> Points the instance attributes of the bound VAO at <paramref name="offset"/> bytes into the bound array buffer. </summary>
+	static void bindInstances(const ShaderProgram& program, const size_t& offset);
+};
\ No newline at end of file
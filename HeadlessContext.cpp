@@ -0,0 +1,256 @@
+#include "HeadlessContext.h"
+#include <cstring>
+#ifdef _WIN32
+#include <GLFW/glfw3.h>
+#else
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+HeadlessContext::HeadlessContext() {
+	width = 0;
+	height = 0;
+	display = nullptr;
+	surface = nullptr;
+	context = nullptr;
+	config = nullptr;
+	loaderSurface = nullptr;
+	loaderContext = nullptr;
+	framebuffer = 0;
+	colorBuffer = 0;
+	depthBuffer = 0;
+}
+
+HeadlessContext::~HeadlessContext() {
+	destroy();
+}
+
+bool HeadlessContext::create(const int& width, const int& height) {
+	destroy();
+	this->width = width;
+	this->height = height;
+
+#ifdef _WIN32
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(1, 1, "LearnOpenGL", NULL, NULL);
+	if (window == NULL) {
+		cout << "Failed to create hidden GLFW window" << endl;
+		glfwTerminate();
+		return false;
+	}
+	context = window;
+	glfwMakeContextCurrent(window);
+	const GLADloadproc load = (GLADloadproc)glfwGetProcAddress;
+#else
+	// Mesa's surfaceless platform needs neither a display server nor a GPU. Other drivers fall back to the default display.
+	EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+	const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (clientExtensions != nullptr && strstr(clientExtensions, "EGL_MESA_platform_surfaceless") != nullptr
+		&& getPlatformDisplay != nullptr) {
+		eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}
+	if (eglDisplay == EGL_NO_DISPLAY) {
+		eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+	if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, nullptr, nullptr)) {
+		cout << "Failed to initialize EGL" << endl;
+		return false;
+	}
+	display = eglDisplay;
+
+	const EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	EGLConfig eglConfig;
+	EGLint configCount = 0;
+	if (!eglChooseConfig(eglDisplay, configAttributes, &eglConfig, 1, &configCount) || configCount == 0) {
+		cout << "No EGL config supports desktop GL" << endl;
+		destroy();
+		return false;
+	}
+	config = eglConfig;
+	// Drawing goes to the framebuffer below, so the surface only has to exist for eglMakeCurrent()
+	const EGLint surfaceAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+	surface = eglCreatePbufferSurface(eglDisplay, eglConfig, surfaceAttributes);
+	if (surface == EGL_NO_SURFACE) {
+		cout << "Failed to create EGL pbuffer" << endl;
+		destroy();
+		return false;
+	}
+
+	eglBindAPI(EGL_OPENGL_API);
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	context = eglCreateContext(eglDisplay, eglConfig, EGL_NO_CONTEXT, contextAttributes);
+	if (context == EGL_NO_CONTEXT || !eglMakeCurrent(eglDisplay, surface, surface, context)) {
+		cout << "Failed to create a 3.3 core EGL context" << endl;
+		destroy();
+		return false;
+	}
+	const GLADloadproc load = (GLADloadproc)eglGetProcAddress;
+#endif
+
+	if (!gladLoadGLLoader(load)) {
+		cout << "Failed to initialize GLAD" << endl;
+		destroy();
+		return false;
+	}
+	loadExtensions(load);
+
+	glGenRenderbuffers(1, &colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glGenRenderbuffers(1, &depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		cout << "Offscreen framebuffer is incomplete" << endl;
+		destroy();
+		return false;
+	}
+	glViewport(0, 0, width, height);
+	return true;
+}
+
+void HeadlessContext::destroy() {
+	if (context != nullptr && framebuffer != 0) {
+		glDeleteFramebuffers(1, &framebuffer);
+		glDeleteRenderbuffers(1, &colorBuffer);
+		glDeleteRenderbuffers(1, &depthBuffer);
+	}
+	framebuffer = 0;
+	colorBuffer = 0;
+	depthBuffer = 0;
+#ifdef _WIN32
+	if (loaderContext != nullptr) {
+		glfwDestroyWindow((GLFWwindow*)loaderContext);
+	}
+	if (context != nullptr) {
+		glfwDestroyWindow((GLFWwindow*)context);
+		glfwTerminate();
+	}
+#else
+	if (display != nullptr) {
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (loaderContext != nullptr) {
+			eglDestroyContext(display, loaderContext);
+		}
+		if (loaderSurface != nullptr) {
+			eglDestroySurface(display, loaderSurface);
+		}
+		if (context != nullptr) {
+			eglDestroyContext(display, context);
+		}
+		if (surface != nullptr) {
+			eglDestroySurface(display, surface);
+		}
+		eglTerminate(display);
+	}
+#endif
+	display = nullptr;
+	surface = nullptr;
+	context = nullptr;
+	config = nullptr;
+	loaderSurface = nullptr;
+	loaderContext = nullptr;
+}
+
+bool HeadlessContext::createLoaderContext() {
+	if (context == nullptr) {
+		cout << "Create the headless context before its loader context" << endl;
+		return false;
+	}
+#ifdef _WIN32
+	// GLFW shares objects between windows created with a share window
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	loaderContext = glfwCreateWindow(1, 1, "LearnOpenGL loader", NULL, (GLFWwindow*)context);
+	if (loaderContext == nullptr) {
+		cout << "Failed to create hidden GLFW loader window" << endl;
+		return false;
+	}
+#else
+	// A surface of its own, so the two contexts can be current on two threads at once
+	const EGLint surfaceAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+	loaderSurface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	loaderContext = eglCreateContext(display, config, context, contextAttributes);
+	if (loaderSurface == EGL_NO_SURFACE || loaderContext == EGL_NO_CONTEXT) {
+		cout << "Failed to create a shared EGL context" << endl;
+		if (loaderContext != EGL_NO_CONTEXT) {
+			eglDestroyContext(display, loaderContext);
+		}
+		if (loaderSurface != EGL_NO_SURFACE) {
+			eglDestroySurface(display, loaderSurface);
+		}
+		loaderSurface = nullptr;
+		loaderContext = nullptr;
+		return false;
+	}
+#endif
+	return true;
+}
+
+void HeadlessContext::bindLoaderContext(const bool& current) {
+#ifdef _WIN32
+	glfwMakeContextCurrent(current ? (GLFWwindow*)loaderContext : NULL);
+#else
+	if (current) {
+		eglMakeCurrent(display, loaderSurface, loaderSurface, loaderContext);
+	}
+	else {
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	}
+#endif
+}
+
+bool HeadlessContext::writeImage(const string& path) const {
+	const size_t rowBytes = (size_t)width * 3;
+	unsigned char* pixels = new unsigned char[rowBytes * height];
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		cout << "Unable to write image " << path << endl;
+		delete[] pixels;
+		return false;
+	}
+	file << "P6\n" << width << " " << height << "\n255\n";
+	// GL rows start at the bottom, image rows at the top
+	for (int y = height - 1; y >= 0; --y) {
+		file.write((const char*)pixels + rowBytes * y, rowBytes);
+	}
+	delete[] pixels;
+	return file.good();
+}
+
+int HeadlessContext::getWidth() const {
+	return width;
+}
+
+int HeadlessContext::getHeight() const {
+	return height;
+}
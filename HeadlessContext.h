@@ -0,0 +1,54 @@
+#pragma once
+#include "WebGLUtility.h"
+
+/// <summary>
+/// A GL context with no window, drawing into an offscreen framebuffer, for rendering on machines without a display.
+/// On Linux the context comes from EGL, which Mesa provides even with no GPU (llvmpipe), so build with -lEGL.
+/// On Windows a hidden GLFW window is used instead.
+///
+/// create() makes the context current, loads GLAD and the extensions, and leaves the framebuffer bound with the
+/// viewport covering it, so everything after it draws exactly as it would to a window.
+/// </summary>
+class HeadlessContext {
+public:
+	HeadlessContext();
+	~HeadlessContext();
+
+	/// <summary> Creates a 3.3 core context and a framebuffer with RGBA8 color and 24-bit depth. </summary>
+	/// <param name="width"> The width of the framebuffer, in pixels. </param>
+	/// <param name="height"> The height of the framebuffer, in pixels. </param>
+	/// <returns> Whether a context could be created. The reason is printed if not. </returns>
+	bool create(const int& width, const int& height);
+	/// <summary> Deletes the framebuffer and the contexts. </summary>
+	void destroy();
+
+	/// <summary> Creates a second context that shares objects with this one, for a ResourceLoader to upload through.
+	/// Call after create(). </summary>
+	/// <returns> Whether the context could be created. The reason is printed if not. </returns>
+	bool createLoaderContext();
+	/// <summary> Makes the loader context current on the calling thread, or releases it. Meant as a ResourceLoader's bindContext. </summary>
+	/// <param name="current"> Whether to make the context current rather than release it. </param>
+	void bindLoaderContext(const bool& current);
+
+	/// <summary> Reads the framebuffer back and writes it as a binary PPM image. Waits for drawing to finish. </summary>
+	/// <param name="path"> The file to write. </param>
+	/// <returns> Whether the file could be written. </returns>
+	bool writeImage(const string& path) const;
+
+	int getWidth() const;
+	int getHeight() const;
+
+private:
+	int width, height;
+	void* display;
+	void* surface;
+	void* context;
+	void* config;
+	void* loaderSurface;
+	void* loaderContext;
+	unsigned int framebuffer, colorBuffer, depthBuffer;
+
+	// The context belongs to one object
+	HeadlessContext(const HeadlessContext&);
+	HeadlessContext& operator=(const HeadlessContext&);
+};
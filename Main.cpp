@@ -8,20 +8,34 @@ Creating using the tutorial at https://learnopengl.com/
 #define _USE_MATH_DEFINES
 #include <GLAD/glad.h>
 #include <GLFW/glfw3.h>
-#include <windows.h>
+#include <chrono>
+#include <cstdio>
+#include <memory>
 #include <thread>
 #include <iostream>
 using std::cout; using std::endl;
+#include "Benchmark.h"
 #include "Camera.h"
 #include "Collision.h"
+#include "HeadlessContext.h"
+#include "MeshShape.h"
 #include "PhysicsSphere.h"
+#include "Profiler.h"
+#include "ResourceLoader.h"
 
 static const double frameTime = 1.0 / 60;
 
+// The math tier used for the camera look vector and movement directions.
+typedef FastMath CameraMath;
+
 GLFWwindow* window;
 
 Camera camera;
 
+RenderQueue renderQueue;
+
+FrameUniforms frameUniforms;
+
 Vector cameraPosition = Vector(0, 0, 30);
 
 Vector look = Vector(0, 0, -1);
@@ -38,10 +52,8 @@ float cameraPhi = 0;
 
 double prevMouseX, prevMouseY;
 
-Particle* particles[2] = {
-	new PhysicsSphere(-10, 0, 0, 2.5),
-	new PhysicsSphere(10, 0, 0, 1)
-};
+// Created in setup(), since shapes rely on statics in other files that are not initialized before main()
+Particle* particles[2];
 
 int frameCount = 0;
 
@@ -60,7 +72,47 @@ void setup();
 // Main render loop
 void render(float);
 
-int main() {
+// Renders frames into an offscreen framebuffer with no window, timing each and optionally writing it as an image.
+// With software, the frames are drawn on the CPU and no GL driver is needed at all. With background, meshes are
+// uploaded on a loader thread as they are in the window, so the first frames may be missing shapes.
+int renderHeadless(const int& frames, const string& imagePrefix, const bool& software, const bool& background);
+
+// Prints the profiler's summary and writes its trace, if profiling was asked for
+void writeProfile(const string& tracePath);
+
+int main(int argc, char** argv) {
+	// --profile <trace.json> goes before any other arguments, and records zones for whatever runs after it
+	string tracePath;
+	if (argc > 2 && string(argv[1]) == "--profile") {
+		Profiler::enabled = true;
+		tracePath = argv[2];
+		argc -= 2;
+		argv += 2;
+	}
+	// Math benchmarks need no window, so they run before any GL setup
+	if (argc > 1 && string(argv[1]) == "--benchmark") {
+		return runBenchmarks(argc > 2 ? argv[2] : "");
+	}
+	// Converting meshes needs no window either
+	if (argc > 1 && string(argv[1]) == "--convert") {
+		if (argc < 4) {
+			cout << "Usage: --convert <input.obj> <output.mesh>" << endl;
+			return -1;
+		}
+		return MeshShape::convert(argv[2], argv[3]) ? 0 : -1;
+	}
+	// Rendering offscreen needs no display, only a GL driver, which may be a software one
+	if (argc > 1 && (string(argv[1]) == "--render" || string(argv[1]) == "--render-software" || string(argv[1]) == "--render-background")) {
+		if (argc < 3) {
+			cout << "Usage: " << argv[1] << " <frames> [imagePrefix]" << endl;
+			return -1;
+		}
+		const int result = renderHeadless(atoi(argv[2]), argc > 3 ? argv[3] : "", string(argv[1]) == "--render-software",
+			string(argv[1]) == "--render-background");
+		writeProfile(tracePath);
+		return result;
+	}
+
 	glfwInit();
 
 	// These two lines tell GLFW that the open GL version is 3.3
@@ -95,28 +147,50 @@ int main() {
 		std::cout << "Failed to initialize GLAD" << std::endl;
 		return -1;
 	}
+	loadExtensions((GLADloadproc)glfwGetProcAddress);
+
+	// Meshes are uploaded through a hidden window sharing this one's objects, and programs start compiling now,
+	// so a shape first seen mid-run is drawn a few frames late instead of stalling the frame it appears in
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* loaderWindow = glfwCreateWindow(1, 1, "LearnOpenGL loader", NULL, window);
+	ResourceLoader* resourceLoader = nullptr;
+	if (loaderWindow != NULL) {
+		resourceLoader = new ResourceLoader([loaderWindow](const bool& current) {
+			glfwMakeContextCurrent(current ? loaderWindow : NULL);
+		});
+		GraphicsShape::loader = resourceLoader;
+	}
+	renderQueue.preload();
+	// Lets the frame rate report tell a slow submit from a slow GPU
+	renderQueue.gpuTiming = true;
 
+	glfwGetCursorPos(window, &prevMouseX, &prevMouseY);
 	setup();
 
 	// Setup window re-size callback
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 
-	LARGE_INTEGER prevTime, time;
-	QueryPerformanceCounter(&prevTime);
+	std::chrono::steady_clock::time_point prevTime = std::chrono::steady_clock::now();
 
 	// Main render loop
 	while (!glfwWindowShouldClose(window))
 	{
-		processInput(window);
+		PROFILE_ZONE_BEGIN(frame, "Frame");
+		{
+			PROFILE_ZONE("Input");
+			processInput(window);
+		}
 		// Determine time of frame
-		QueryPerformanceCounter(&time);
-		LARGE_INTEGER timerFreq;
-		QueryPerformanceFrequency(&timerFreq);
-		const double freq = 1.0f / timerFreq.QuadPart;
-		const double timeSeconds = (time.QuadPart - prevTime.QuadPart) * freq;
+		const std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now();
+		const double timeSeconds = std::chrono::duration<double>(time - prevTime).count();
 		render((float) timeSeconds);
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+		{
+			PROFILE_ZONE("Swap");
+			glfwSwapBuffers(window);
+			glfwPollEvents();
+		}
+		// The frame is what was worked on, not the sleep that paces it
+		PROFILE_ZONE_END(frame);
 		if (timeSeconds < frameTime) {
 			std::this_thread::sleep_for(std::chrono::milliseconds((int) ((frameTime - timeSeconds) * 1000)));
 			if (frameCount % 60 == 59) {
@@ -125,14 +199,19 @@ int main() {
 		}
 		else {
 			if (frameCount % 60 == 59) {
-				cout << 1.0 / timeSeconds << " fps" << endl;
+				const RenderQueue::Stats& stats = renderQueue.getStats();
+				cout << 1.0 / timeSeconds << " fps, submit " << stats.cpuMilliseconds << " ms, GPU " << stats.gpuMilliseconds << " ms" << endl;
 			}
 		}
 
 		prevTime = time;
 		++frameCount;
 	}
+	GraphicsShape::loader = nullptr;
+	delete resourceLoader;
+	renderQueue.release();
 	glfwTerminate();
+	writeProfile(tracePath);
 
 	return 0;
 }
@@ -140,10 +219,13 @@ int main() {
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
 	glViewport(0, 0, width, height);
+	renderQueue.setViewport(width, height);
 }
 
 void cursor_position_callback(GLFWwindow* window, double xpos, double ypos) { 
 	cameraTheta += (float) (xpos - prevMouseX) / 1000 * (float) M_PI;
+	// Keep theta small so the fast sin/cos tier stays inside its documented range
+	cameraTheta = fmodf(cameraTheta, 2 * (float) M_PI);
 	cameraPhi += (float) (ypos - prevMouseY) / 1000 * (float) M_PI;
 	if (cameraPhi > (float) M_PI / 2 - 0.0001f) {
 		cameraPhi = (float) M_PI / 2 - 0.0001f;
@@ -160,13 +242,13 @@ void processInput(GLFWwindow* window)
 	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
 		glfwSetWindowShouldClose(window, true);
 	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-		movement += ~Vector(look.getX(), 0, look.getZ());
+		movement += Vector(look.getX(), 0, look.getZ()).normalized<CameraMath>();
 	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-		movement -= ~Vector(look.getX(), 0, look.getZ());
+		movement -= Vector(look.getX(), 0, look.getZ()).normalized<CameraMath>();
 	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-		movement += ~(Vector(0, 1, 0) % look);
+		movement += (Vector(0, 1, 0) % look).normalized<CameraMath>();
 	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-		movement -= ~(Vector(0, 1, 0) % look);
+		movement -= (Vector(0, 1, 0) % look).normalized<CameraMath>();
 	if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS)
 		movement += Vector(0, 1, 0);
 	if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS)
@@ -178,39 +260,128 @@ void processInput(GLFWwindow* window)
 }
 
 void setup() {
-	glfwGetCursorPos(window, &prevMouseX, &prevMouseY);
-
 	// Camera
 	//camera.frustum(-5 * aspect, 5 * aspect, -5, 5, 10, 250);
 	camera.frustum(-0.1f * aspect, 0.1f * aspect, -0.1f, 0.1f, 0.1f, 250);
 
-	// Create a GL window
-	glViewport(0, 0, 1000, 1000);
-	// Create background color
-	glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-	// Turn on depth testing
-	glClearDepth(1);
-	glEnable(GL_DEPTH_TEST);
-	// Back face culling
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
+	if (renderQueue.software == nullptr) {
+		// Create a GL window
+		glViewport(0, 0, 1000, 1000);
+		renderQueue.setViewport(1000, 1000);
+		// Create background color
+		glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+		// Turn on depth testing
+		glClearDepth(1);
+		glEnable(GL_DEPTH_TEST);
+		// Back face culling
+		glEnable(GL_CULL_FACE);
+		glCullFace(GL_BACK);
+	}
 
+	particles[0] = new PhysicsSphere(-10, 0, 0, 2.5);
+	particles[1] = new PhysicsSphere(10, 0, 0, 1);
 	particles[0]->addVelocity(1, 0, 0);
 	particles[1]->addVelocity(-1, 0, 0);
 }
 
 void render(float time) {
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	// Meshes the loader has finished become drawable this frame
+	if (GraphicsShape::loader != nullptr) {
+		GraphicsShape::loader->poll();
+	}
+	if (renderQueue.software != nullptr) {
+		renderQueue.software->clear(1.0f, 1.0f, 1.0f);
+	}
+	else {
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	}
+	float sinPhi, cosPhi, sinTheta, cosTheta;
+	CameraMath::sincos(cameraPhi, sinPhi, cosPhi);
+	CameraMath::sincos(cameraTheta, sinTheta, cosTheta);
 	look = -Vector(
-		cosf(cameraPhi) * cosf(cameraTheta),
-		sinf(cameraPhi),
-		cosf(cameraPhi) * sinf(cameraTheta)
+		cosPhi * cosTheta,
+		sinPhi,
+		cosPhi * sinTheta
 	);
 
 	camera.viewPoint(cameraPosition, look, Vector(0, 1, 0));
+	if (renderQueue.software == nullptr) {
+		frameUniforms.update(camera);
+	}
 	particles[0]->updatePhysics(time);
 	particles[1]->updatePhysics(time);
-	particles[0]->draw(camera.getProjection(), camera.getView());
-	particles[1]->draw(camera.getProjection(), camera.getView());
-	checkCollision(particles[0], particles[1]);
-}
\ No newline at end of file
+	particles[0]->submit(renderQueue);
+	particles[1]->submit(renderQueue);
+	renderQueue.flush(camera.getProjection(), camera.getView());
+	{
+		// Every pair is tested, so there is no broadphase to time apart from the narrowphase and solve inside this
+		PROFILE_ZONE("Collisions");
+		checkCollision(particles[0], particles[1]);
+	}
+}
+
+int renderHeadless(const int& frames, const string& imagePrefix, const bool& software, const bool& background) {
+	HeadlessContext headless;
+	// Only made when drawing on the CPU, since its color and depth buffers and tile bins are large
+	std::unique_ptr<SoftwareRasterizer> rasterizer;
+	if (software) {
+		rasterizer.reset(new SoftwareRasterizer(windowWidth, windowHeight));
+		renderQueue.software = rasterizer.get();
+	}
+	else if (!headless.create(windowWidth, windowHeight)) {
+		return -1;
+	}
+	// Otherwise nothing is loaded in the background, so every frame draws every shape and the images are the same each run.
+	// Declared after the context, so the loader thread lets go of its context before the contexts are destroyed.
+	std::unique_ptr<ResourceLoader> resourceLoader;
+	if (background && !software && headless.createLoaderContext()) {
+		resourceLoader.reset(new ResourceLoader([&headless](const bool& current) {
+			headless.bindLoaderContext(current);
+		}));
+		GraphicsShape::loader = resourceLoader.get();
+		renderQueue.preload();
+	}
+	setup();
+	renderQueue.gpuTiming = !software && Profiler::enabled;
+	int result = 0;
+	for (int frame = 0; frame < frames && result == 0; ++frame) {
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		PROFILE_ZONE_BEGIN(frameZone, "Frame");
+		// A fixed time step, so the same frame is the same image on every run
+		render((float) frameTime);
+		if (!software) {
+			PROFILE_ZONE("Finish");
+			glFinish();
+		}
+		PROFILE_ZONE_END(frameZone);
+		const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		cout << "Frame " << frame << ": " << milliseconds << " ms";
+		if (renderQueue.getStats().gpuMilliseconds >= 0) {
+			cout << " (GPU " << renderQueue.getStats().gpuMilliseconds << " ms)";
+		}
+		cout << endl;
+		if (!imagePrefix.empty()) {
+			char number[16];
+			snprintf(number, sizeof(number), "%04d", frame);
+			const string path = imagePrefix + number + ".ppm";
+			if (!(software ? rasterizer->writeImage(path) : headless.writeImage(path))) {
+				result = -1;
+			}
+		}
+	}
+	// The queue outlives the context, the rasterizer and the loader
+	renderQueue.release();
+	renderQueue.software = nullptr;
+	GraphicsShape::loader = nullptr;
+	return result;
+}
+
+void writeProfile(const string& tracePath) {
+	if (!Profiler::enabled) {
+		return;
+	}
+	Profiler::printSummary();
+	if (Profiler::writeTrace(tracePath)) {
+		cout << "Trace written to " << tracePath << endl;
+	}
+}
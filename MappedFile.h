@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+using std::string;
+
+/// <summary>
+/// A file mapped read-only into memory. Pages are read from disk the first time they are touched, and stay shared
+/// with the operating system's file cache, so opening even a large file costs next to nothing.
+/// </summary>
+class MappedFile {
+public:
+	MappedFile();
+	~MappedFile();
+
+	/// <summary> Maps a file. Any previously opened file is closed first. </summary>
+	/// <param name="path"> The path to the file. </param>
+	/// <returns> Whether the file exists and could be mapped. Empty files cannot be. </returns>
+	bool open(const string& path);
+	/// <summary> Unmaps the file. Pointers into it become invalid. </summary>
+	void close();
+
+	/// <summary> Returns the first byte of the file, or nullptr if no file is open. </summary>
+	const unsigned char* getData() const;
+	/// <summary> Returns the size of the file in bytes. </summary>
+	size_t getSize() const;
+
+private:
+	const unsigned char* data;
+	size_t size;
+#ifdef _WIN32
+	void* file;
+	void* mapping;
+#endif
+
+	// The mapping belongs to one object
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+};
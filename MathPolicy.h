@@ -0,0 +1,77 @@
+#pragma once
+#include <cmath>
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define MATH_POLICY_SSE
+#include <xmmintrin.h>
+#endif
+
+/// <summary>
+/// Full precision math tier. Forwards to the C runtime, so results are correctly rounded (sqrt) or within the
+/// runtime's own error bound (sin, cos). This is the tier used by every non-templated Vector and Matrix function.
+/// </summary>
+struct PreciseMath {
+	/// <summary> Square root of <paramref name="x"/>. </summary>
+	static inline float sqrt(const float& x) {
+		return sqrtf(x);
+	}
+
+	/// <summary> Reciprocal square root of <paramref name="x"/>. </summary>
+	static inline float rsqrt(const float& x) {
+		return 1 / sqrtf(x);
+	}
+
+	/// <summary> Sine and cosine of <paramref name="x"/>, in radians. </summary>
+	static inline void sincos(const float& x, float& sin, float& cos) {
+		sin = sinf(x);
+		cos = cosf(x);
+	}
+};
+
+/// <summary>
+/// Reduced precision math tier, for hot paths that can trade a few ulp for throughput.
+/// Error bounds, measured against double precision references:
+///   rsqrt  - hardware estimate plus one Newton-Raphson step, at most 4 ulp over the normal float range.
+///   sqrt   - x * rsqrt(x), at most 5 ulp. Returns 0 for 0.
+///   sincos - Cody-Waite reduction to [-pi/4, pi/4] and minimax polynomials, at most 1.5 ulp over [-pi, pi]
+///            and at most 1e-7 absolute error for |x| &lt;= 8192. Larger arguments lose precision linearly.
+/// </summary>
+struct FastMath {
+	/// <summary> Reciprocal square root of <paramref name="x"/>. <paramref name="x"/> must be positive. </summary>
+	static inline float rsqrt(const float& x) {
+#ifdef MATH_POLICY_SSE
+		const float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+#else
+		// Bit level estimate, refined twice more here so the final step lands within the same bound.
+		union { float f; unsigned int i; } bits = { x };
+		bits.i = 0x5f375a86 - (bits.i >> 1);
+		float y = bits.f;
+		y = y * (1.5f - 0.5f * x * y * y);
+		y = y * (1.5f - 0.5f * x * y * y);
+#endif
+		return y * (1.5f - 0.5f * x * y * y);
+	}
+
+	/// <summary> Square root of <paramref name="x"/>. <paramref name="x"/> must not be negative. </summary>
+	static inline float sqrt(const float& x) {
+		return x > 0 ? x * rsqrt(x) : 0;
+	}
+
+	/// <summary> Sine and cosine of <paramref name="x"/>, in radians. </summary>
+	static inline void sincos(const float& x, float& sin, float& cos) {
+		// Reduce to r in [-pi/4, pi/4], with x = r + k * pi/2. pi/2 is split into three parts so k * part is exact.
+		const int k = (int)(x * 0.636619772f + (x >= 0 ? 0.5f : -0.5f));
+		const float fk = (float)k;
+		float r = x - fk * 1.5703125f;
+		r -= fk * 4.83751297e-4f;
+		r -= fk * 7.54978995e-8f;
+		const float r2 = r * r;
+		const float s = r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+		const float c = 1 + r2 * (-0.5f + r2 * (4.166664568e-2f + r2 * (-1.388731625e-3f + r2 * 2.443315711e-5f)));
+		switch (k & 3) {
+		case 0: sin = s; cos = c; break;
+		case 1: sin = c; cos = -s; break;
+		case 2: sin = -s; cos = -c; break;
+		default: sin = -c; cos = s; break;
+		}
+	}
+};
@@ -91,12 +91,19 @@ Matrix Matrix::scale(const float& sx, const float& sy, const float& sz, const fl
 	return (translate(x, y, z) * Matrix(arr)).translate(-x, -y, -z);
 }
 
+Matrix Matrix::rotateX(const float& theta, const bool& radians, const float& x, const float& y, const float& z) const {
+	return rotateX<PreciseMath>(theta, radians, x, y, z);
+}
+
+template<class Math>
 Matrix Matrix::rotateX(const float& theta, const bool& radians, const float& x, const float& y, const float& z) const {
 	float t = theta;
 	if (!radians) {
 		t = t * (float) M_PI / 180;
 	}
-	return rotateXSC(sinf(t), cosf(t), x, y, z);
+	float sin, cos;
+	Math::sincos(t, sin, cos);
+	return rotateXSC(sin, cos, x, y, z);
 }
 
 Matrix Matrix::rotateXSC(const float& sin, const float& cos, const float& x, const float& y, const float& z) const {
@@ -108,12 +115,19 @@ Matrix Matrix::rotateXSC(const float& sin, const float& cos, const float& x, con
 	};
 	return (translate(x, y, z) * Matrix(arr)).translate(-x, -y, -z);
 }
+Matrix Matrix::rotateY(const float& theta, const bool& radians, const float& x, const float& y, const float& z) const {
+	return rotateY<PreciseMath>(theta, radians, x, y, z);
+}
+
+template<class Math>
 Matrix Matrix::rotateY(const float& theta, const bool& radians, const float& x, const float& y, const float& z) const {
 	float t = theta;
 	if (!radians) {
 		t = t * (float) M_PI / 180;
 	}
-	return rotateYSC(sinf(t), cosf(t), x, y, z);
+	float sin, cos;
+	Math::sincos(t, sin, cos);
+	return rotateYSC(sin, cos, x, y, z);
 }
 
 Matrix Matrix::rotateYSC(const float& sin, const float& cos, const float& x, const float& y, const float& z) const {
@@ -126,12 +140,19 @@ Matrix Matrix::rotateYSC(const float& sin, const float& cos, const float& x, con
 	return (translate(x, y, z) * Matrix(arr)).translate(-x, -y, -z);
 }
 
+Matrix Matrix::rotateZ(const float& theta, const bool& radians, const float& x, const float& y, const float& z) const {
+	return rotateZ<PreciseMath>(theta, radians, x, y, z);
+}
+
+template<class Math>
 Matrix Matrix::rotateZ(const float& theta, const bool& radians, const float& x, const float& y, const float& z) const {
 	float t = theta;
 	if (!radians) {
 		t = t * (float) M_PI / 180;
 	}
-	return rotateZSC(sinf(t), cosf(t), x, y, z);
+	float sin, cos;
+	Math::sincos(t, sin, cos);
+	return rotateZSC(sin, cos, x, y, z);
 }
 
 Matrix Matrix::rotateZSC(const float& sin, const float& cos, const float& x, const float& y, const float& z) const {
@@ -144,6 +165,11 @@ Matrix Matrix::rotateZSC(const float& sin, const float& cos, const float& x, con
 	return (translate(x, y, z) * Matrix(arr)).translate(-x, -y, -z);
 }
 
+Matrix Matrix::rotate(const float& thetax, const float& thetay, const float& thetaz, const bool& radians, const float& x, const float& y, const float& z) const {
+	return rotate<PreciseMath>(thetax, thetay, thetaz, radians, x, y, z);
+}
+
+template<class Math>
 Matrix Matrix::rotate(const float& thetax, const float& thetay, const float& thetaz, const bool& radians, const float& x, const float& y, const float& z) const {
 	float tx = thetax;
 	float ty = thetay;
@@ -153,9 +179,22 @@ Matrix Matrix::rotate(const float& thetax, const float& thetay, const float& the
 		ty = ty * (float) M_PI / 180;
 		tz = tz * (float) M_PI / 180;
 	}
-	return rotateSC(sinf(tx), cosf(tx), sinf(ty), cosf(ty), sinf(tz), cosf(tz), x, y, z);
+	float sinx, cosx, siny, cosy, sinz, cosz;
+	Math::sincos(tx, sinx, cosx);
+	Math::sincos(ty, siny, cosy);
+	Math::sincos(tz, sinz, cosz);
+	return rotateSC(sinx, cosx, siny, cosy, sinz, cosz, x, y, z);
 }
 
 Matrix Matrix::rotateSC(const float& sinx, const float& cosx, const float& siny, const float& cosy, const float& sinz, const float& cosz, const float& x, const float& y, const float& z) const {
 	return this->rotateXSC(sinx, cosx, x, y, z).rotateYSC(siny, cosy, x, y, z).rotateZSC(sinz, cosz, x, y, z);
-}
\ No newline at end of file
+}
+
+template Matrix Matrix::rotateX<PreciseMath>(const float&, const bool&, const float&, const float&, const float&) const;
+template Matrix Matrix::rotateX<FastMath>(const float&, const bool&, const float&, const float&, const float&) const;
+template Matrix Matrix::rotateY<PreciseMath>(const float&, const bool&, const float&, const float&, const float&) const;
+template Matrix Matrix::rotateY<FastMath>(const float&, const bool&, const float&, const float&, const float&) const;
+template Matrix Matrix::rotateZ<PreciseMath>(const float&, const bool&, const float&, const float&, const float&) const;
+template Matrix Matrix::rotateZ<FastMath>(const float&, const bool&, const float&, const float&, const float&) const;
+template Matrix Matrix::rotate<PreciseMath>(const float&, const float&, const float&, const bool&, const float&, const float&, const float&) const;
+template Matrix Matrix::rotate<FastMath>(const float&, const float&, const float&, const bool&, const float&, const float&, const float&) const;
\ No newline at end of file
@@ -3,6 +3,7 @@
 #define M_PI 3.14159265358979323846
 #endif
 #include <cmath>
+#include "MathPolicy.h"
 #include "Vector.h"
 
 /// <summary>
@@ -77,6 +78,14 @@ public:
 	/// <param name="radians"> Whether the rotation is in radians or degrees. </param>
 	Matrix rotateX(const float& theta, const bool& radians = false, const float& x = 0, const float& y = 0, const float& z = 0) const;
 
+	/// <summary> Returns this matrix rotated around the x-axis, computing sin and cos with the math tier <typeparamref name="Math"/>. </summary>
+	/// <param name="theta"> The amount to rotate. </param>
+	/// <param name="radians"> Whether the rotation is in radians or degrees. </param>
+	/// <param name="x"> The x value to rotate around. </param>
+	/// <param name="y"> The y value to rotate around. </param>
+	/// <param name="z"> The z value to rotate around. </param>
+	template<class Math> Matrix rotateX(const float& theta, const bool& radians = false, const float& x = 0, const float& y = 0, const float& z = 0) const;
+
 	/// <summary> 
 	/// Returns this matrix rotated around the x-axis by <paramref name="sin"/>, <paramref name="cos"/> around the point <paramref name="x"/>, <paramref name="y"/>, <paramref name="z"/>
 	/// This function is best used to avoid re-calculating sin and cos values when rotating multiple matrices at once.
@@ -96,6 +105,14 @@ public:
 	/// <param name="radians"> Whether the rotation is in radians or degrees. </param>
 	Matrix rotateY(const float& theta, const bool& radians = false, const float& x = 0, const float& y = 0, const float& z = 0) const;
 
+	/// <summary> Returns this matrix rotated around the y-axis, computing sin and cos with the math tier <typeparamref name="Math"/>. </summary>
+	/// <param name="theta"> The amount to rotate. </param>
+	/// <param name="radians"> Whether the rotation is in radians or degrees. </param>
+	/// <param name="x"> The x value to rotate around. </param>
+	/// <param name="y"> The y value to rotate around. </param>
+	/// <param name="z"> The z value to rotate around. </param>
+	template<class Math> Matrix rotateY(const float& theta, const bool& radians = false, const float& x = 0, const float& y = 0, const float& z = 0) const;
+
 	/// <summary> 
 	/// Returns this matrix rotated around the y-axis by <paramref name="sin"/>, <paramref name="cos"/> around the point <paramref name="x"/>, <paramref name="y"/>, <paramref name="z"/>
 	/// This function is best used to avoid re-calculating sin and cos values when rotating multiple matrices at once.
@@ -115,6 +132,14 @@ public:
 	/// <param name="radians"> Whether the rotation is in radians or degrees. </param>
 	Matrix rotateZ(const float& theta, const bool& radians = false, const float& x = 0, const float& y = 0, const float& z = 0) const;
 
+	/// <summary> Returns this matrix rotated around the z-axis, computing sin and cos with the math tier <typeparamref name="Math"/>. </summary>
+	/// <param name="theta"> The amount to rotate. </param>
+	/// <param name="radians"> Whether the rotation is in radians or degrees. </param>
+	/// <param name="x"> The x value to rotate around. </param>
+	/// <param name="y"> The y value to rotate around. </param>
+	/// <param name="z"> The z value to rotate around. </param>
+	template<class Math> Matrix rotateZ(const float& theta, const bool& radians = false, const float& x = 0, const float& y = 0, const float& z = 0) const;
+
 	/// <summary>
 	/// Returns this matrix rotated around the z-axis by <paramref name="sin"/>, <paramref name="cos"/> around the point <paramref name="x"/>, <paramref name="y"/>, <paramref name="z"/>
 	/// This function is best used to avoid re-calculating sin and cos values when rotating multiple matrices at once.
@@ -142,6 +167,16 @@ public:
 	/// <param name="radians"> Whether the rotation is in radians or degrees. </param>
 	Matrix rotate(const float& thetax, const float& thetay, const float& thetaz, const bool& radians = false, const float& x = 0, const float& y = 0, const float& z = 0) const;
 
+	/// <summary> Returns this matrix rotated around all three axes, computing sin and cos with the math tier <typeparamref name="Math"/>. </summary>
+	/// <param name="thetax"> The amount to rotate around the x-axis. </param>
+	/// <param name="thetay"> The amount to rotate around the y-axis. </param>
+	/// <param name="thetaz"> The amount to rotate around the z-axis. </param>
+	/// <param name="radians"> Whether the rotation is in radians or degrees. </param>
+	/// <param name="x"> The x value to rotate around. </param>
+	/// <param name="y"> The y value to rotate around. </param>
+	/// <param name="z"> The z value to rotate around. </param>
+	template<class Math> Matrix rotate(const float& thetax, const float& thetay, const float& thetaz, const bool& radians = false, const float& x = 0, const float& y = 0, const float& z = 0) const;
+
 	/// <summary> 
 	/// Returns this matrix rotated by <paramref name="sinx"/>,  <paramref name="cosx"/> around x-axis,
 	/// <paramref name="siny"/>, <paramref name="cosy"/> around y-axis,
@@ -0,0 +1,158 @@
+#include "MeshCache.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+using std::cout; using std::endl;
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+MeshCache::MeshCache() {
+	data = nullptr;
+	size = 0;
+	header = nullptr;
+	firstIndex = nullptr;
+}
+
+MeshCache::~MeshCache() {
+	close();
+}
+
+unsigned int MeshCache::checksum(const void* data, const size_t& bytes, const unsigned int& hash) {
+	const unsigned char* byte = (const unsigned char*)data;
+	unsigned int result = hash;
+	for (size_t i = 0; i < bytes; ++i) {
+		result ^= byte[i];
+		result *= 16777619u;
+	}
+	return result;
+}
+
+bool MeshCache::open(const string& path, const unsigned int& key) {
+	close();
+
+	if (!file.open(path) || file.getSize() < sizeof(Header)) {
+		close();
+		return false;
+	}
+	data = file.getData();
+	size = file.getSize();
+
+	header = (const Header*)data;
+	if (header->magic != magic || header->version != version || header->key != key || header->indexSize != indexSize) {
+		close();
+		return false;
+	}
+
+	// Check every array fits before trusting the counts
+	size_t offset = sizeof(Header);
+	const size_t lods = header->lods;
+	if (size < offset + lods * (sizeof(unsigned int) + sizeof(float))
+		|| checksum(data + offset, lods * (sizeof(unsigned int) + sizeof(float))) != header->tableChecksum) {
+		close();
+		return false;
+	}
+	numIndices = (const unsigned int*)(data + offset);
+	offset += lods * sizeof(unsigned int);
+	errors = (const float*)(data + offset);
+	offset += lods * sizeof(float);
+	vertices = (const float*)(data + offset);
+	offset += (size_t)header->numVertices * 3 * sizeof(float);
+	colors = (const float*)(data + offset);
+	offset += (size_t)header->numVertices * 4 * sizeof(float);
+	indices = (const unsigned int*)(data + offset);
+	firstIndex = new unsigned int[lods];
+	size_t totalIndices = 0;
+	for (size_t i = 0; i < lods; ++i) {
+		firstIndex[i] = (unsigned int)totalIndices;
+		totalIndices += numIndices[i];
+	}
+	offset += totalIndices * indexSize;
+	if (offset != size) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MeshCache::close() {
+	file.close();
+	delete[] firstIndex;
+	firstIndex = nullptr;
+	data = nullptr;
+	header = nullptr;
+	size = 0;
+}
+
+bool MeshCache::write(const string& path, const unsigned int& key, const unsigned int& numVertices, const float* vertices, const float* colors,
+	const unsigned int& lods, const unsigned int* numIndices, const unsigned int* const* indices, const float* errors) {
+	Header header = {};
+	header.magic = magic;
+	header.version = version;
+	header.key = key;
+	header.numVertices = numVertices;
+	header.lods = lods;
+	header.indexSize = indexSize;
+
+	header.tableChecksum = checksum(errors, lods * sizeof(float), checksum(numIndices, lods * sizeof(unsigned int)));
+
+	// Write beside the real file and swap it in, so a process starting meanwhile never maps half a file
+	const string temporary = path + ".tmp";
+	std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+	if (!out.is_open()) {
+		cout << "Unable to write mesh cache at path: " << path << endl;
+		return false;
+	}
+	out.write((const char*)&header, sizeof(Header));
+	out.write((const char*)numIndices, lods * sizeof(unsigned int));
+	out.write((const char*)errors, lods * sizeof(float));
+	out.write((const char*)vertices, numVertices * 3 * sizeof(float));
+	out.write((const char*)colors, numVertices * 4 * sizeof(float));
+	for (unsigned int i = 0; i < lods; ++i) {
+		out.write((const char*)indices[i], numIndices[i] * indexSize);
+	}
+	out.close();
+	if (out.fail()) {
+		cout << "Unable to write mesh cache at path: " << path << endl;
+		std::remove(temporary.c_str());
+		return false;
+	}
+#ifdef _WIN32
+	if (!MoveFileExA(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+#else
+	if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+#endif
+		cout << "Unable to write mesh cache at path: " << path << endl;
+		std::remove(temporary.c_str());
+		return false;
+	}
+	return true;
+}
+
+unsigned int MeshCache::getNumVertices() const {
+	return header->numVertices;
+}
+
+const float* MeshCache::getVertices() const {
+	return vertices;
+}
+
+const float* MeshCache::getColors() const {
+	return colors;
+}
+
+unsigned int MeshCache::getLODs() const {
+	return header->lods;
+}
+
+unsigned int MeshCache::getNumIndices(const unsigned int& lod) const {
+	return numIndices[lod];
+}
+
+const unsigned int* MeshCache::getIndices(const unsigned int& lod) const {
+	return indices + firstIndex[lod];
+}
+
+float MeshCache::getError(const unsigned int& lod) const {
+	return errors[lod];
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include "MappedFile.h"
+
+/// <summary>
+/// A generated mesh saved to disk, so it only has to be generated once.
+/// The file holds the vertex positions and colors, and an index buffer and error value per level of detail.
+/// Loading maps the file into memory, and the accessors point straight into the mapping, so nothing is copied.
+///
+/// Each file is stamped with a key describing how the mesh was generated; a file with a different key, whose arrays do
+/// not add up to its size, or whose level tables fail their checksum, is refused and should be regenerated. The vertex
+/// and index arrays are not hashed, since that would read every page of the mapping on every start.
+/// </summary>
+class MeshCache {
+public:
+	/// <summary> The bytes per index stored in the file. Indices are narrowed, where they fit, when they are uploaded. </summary>
+	static const unsigned int indexSize = sizeof(unsigned int);
+
+	MeshCache();
+	~MeshCache();
+
+	/// <summary> Maps a cache file. Any previously opened file is closed first. </summary>
+	/// <param name="path"> The path to the cache file. </param>
+	/// <param name="key"> The key the file must have been written with. </param>
+	/// <returns> Whether the file exists, matches <paramref name="key"/> and is intact. </returns>
+	bool open(const string& path, const unsigned int& key);
+	/// <summary> Unmaps the file. Pointers returned by the accessors become invalid. </summary>
+	void close();
+
+	/// <summary> Writes a cache file, replacing any file already at <paramref name="path"/>. </summary>
+	/// <param name="path"> The path to write to. </param>
+	/// <param name="key"> The key describing how the mesh was generated. </param>
+	/// <param name="numVertices"> The number of vertices. </param>
+	/// <param name="vertices"> The vertex positions, 3 floats per vertex. </param>
+	/// <param name="colors"> The vertex colors, 4 floats per vertex. </param>
+	/// <param name="lods"> The number of levels of detail. </param>
+	/// <param name="numIndices"> The number of indices of each level. </param>
+	/// <param name="indices"> The indices of each level. </param>
+	/// <param name="errors"> The error of each level. </param>
+	/// <returns> Whether the file was written. </returns>
+	static bool write(const string& path, const unsigned int& key, const unsigned int& numVertices, const float* vertices, const float* colors,
+		const unsigned int& lods, const unsigned int* numIndices, const unsigned int* const* indices, const float* errors);
+
+	/// <summary> Hashes bytes with 32-bit FNV-1a. </summary>
+	/// <param name="data"> The bytes to hash. </param>
+	/// <param name="bytes"> The number of bytes. </param>
+	/// <param name="hash"> The hash to continue from, so several ranges can be hashed as one. </param>
+	static unsigned int checksum(const void* data, const size_t& bytes, const unsigned int& hash = 2166136261u);
+
+	/// <summary> Returns the number of vertices. </summary>
+	unsigned int getNumVertices() const;
+	/// <summary> Returns the vertex positions, 3 floats per vertex. </summary>
+	const float* getVertices() const;
+	/// <summary> Returns the vertex colors, 4 floats per vertex. </summary>
+	const float* getColors() const;
+	/// <summary> Returns the number of levels of detail. </summary>
+	unsigned int getLODs() const;
+	/// <summary> Returns the number of indices of a level of detail. </summary>
+	unsigned int getNumIndices(const unsigned int& lod) const;
+	/// <summary> Returns the indices of a level of detail. </summary>
+	const unsigned int* getIndices(const unsigned int& lod) const;
+	/// <summary> Returns the error of a level of detail. </summary>
+	float getError(const unsigned int& lod) const;
+
+private:
+	/// <summary> The start of every cache file. The arrays follow in the order of the accessors. </summary>
+	struct Header {
+		unsigned int magic;
+		unsigned int version;
+		unsigned int key;
+		/// <summary> A checksum of the index counts and errors, which every other array's size is worked out from. </summary>
+		unsigned int tableChecksum;
+		unsigned int numVertices;
+		unsigned int lods;
+		unsigned int indexSize;
+		unsigned int reserved;
+	};
+
+	static const unsigned int magic = 0x4853454D; // "MESH"
+	static const unsigned int version = 3;
+
+	const unsigned char* data;
+	size_t size;
+	const Header* header;
+	const unsigned int* numIndices;
+	const float* errors;
+	const float* vertices;
+	const float* colors;
+	const unsigned int* indices;
+	/// <summary> The offset of each level's first index within indices. </summary>
+	unsigned int* firstIndex;
+	MappedFile file;
+};
@@ -0,0 +1,90 @@
+#include "MeshEdges.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+	/// <summary> Identifies an edge by its two vertices, whichever way round they are given. </summary>
+	unsigned long long edgeKey(const unsigned int& a, const unsigned int& b) {
+		return a < b ? (unsigned long long)a << 32 | b : (unsigned long long)b << 32 | a;
+	}
+}
+
+unsigned int extractEdges(unsigned int* destination, const unsigned int* indices, const unsigned int& count, const float* vertices, const float& creaseAngle) {
+	const unsigned int triangles = count / 3;
+	std::vector<float> normals(triangles * 3);
+	for (unsigned int t = 0; t < triangles; ++t) {
+		const float* a = vertices + indices[t * 3] * 3;
+		const float* b = vertices + indices[t * 3 + 1] * 3;
+		const float* c = vertices + indices[t * 3 + 2] * 3;
+		const float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		const float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		float* normal = &normals[t * 3];
+		normal[0] = ab[1] * ac[2] - ab[2] * ac[1];
+		normal[1] = ab[2] * ac[0] - ab[0] * ac[2];
+		normal[2] = ab[0] * ac[1] - ab[1] * ac[0];
+		const float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		// Degenerate triangles get no direction, so every edge they share looks like a crease
+		const float inverse = length > 0 ? 1 / length : 0;
+		for (int axis = 0; axis < 3; ++axis) {
+			normal[axis] *= inverse;
+		}
+	}
+
+	// Sorting the sides of every triangle by edge puts the faces sharing an edge next to each other
+	struct Side {
+		unsigned long long key;
+		unsigned int triangle;
+		bool operator<(const Side& other) const { return key < other.key; }
+	};
+	std::vector<Side> sides(triangles * 3);
+	for (unsigned int t = 0; t < triangles; ++t) {
+		for (int corner = 0; corner < 3; ++corner) {
+			sides[t * 3 + corner].key = edgeKey(indices[t * 3 + corner], indices[t * 3 + (corner + 1) % 3]);
+			sides[t * 3 + corner].triangle = t;
+		}
+	}
+	std::sort(sides.begin(), sides.end());
+
+	const float threshold = cosf(creaseAngle);
+	unsigned int written = 0;
+	size_t first = 0;
+	while (first < sides.size()) {
+		size_t last = first + 1;
+		while (last < sides.size() && sides[last].key == sides[first].key) {
+			++last;
+		}
+		// Open edges have one face and non-manifold ones more than two, and both are always kept
+		bool edge = last - first != 2;
+		if (!edge) {
+			const float* n0 = &normals[sides[first].triangle * 3];
+			const float* n1 = &normals[sides[first + 1].triangle * 3];
+			edge = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2] < threshold;
+		}
+		if (edge) {
+			destination[written++] = (unsigned int)(sides[first].key >> 32);
+			destination[written++] = (unsigned int)(sides[first].key & 0xFFFFFFFF);
+		}
+		first = last;
+	}
+	return written;
+}
+
+void computeEdgeMasks(unsigned char* destination, const unsigned int* indices, const unsigned int& count, const unsigned int* edges, const unsigned int& edgeCount) {
+	std::vector<unsigned long long> keys(edgeCount / 2);
+	for (unsigned int i = 0; i < edgeCount / 2; ++i) {
+		keys[i] = edgeKey(edges[i * 2], edges[i * 2 + 1]);
+	}
+	std::sort(keys.begin(), keys.end());
+
+	for (unsigned int t = 0; t < count / 3; ++t) {
+		unsigned char mask = 0;
+		for (int side = 0; side < 3; ++side) {
+			const unsigned long long key = edgeKey(indices[t * 3 + side], indices[t * 3 + (side + 1) % 3]);
+			if (std::binary_search(keys.begin(), keys.end(), key)) {
+				mask |= 1 << side;
+			}
+		}
+		destination[t] = mask;
+	}
+}
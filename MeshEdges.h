@@ -0,0 +1,23 @@
+#pragma once
+
+// Edges of indexed triangle lists: the lines worth drawing on a mesh, as opposed to every side of every triangle.
+
+/// <summary> Finds the edges of a triangle list where two faces meet at more than <paramref name="creaseAngle"/>,
+/// along with its open and non-manifold edges. Edges between nearly coplanar faces, such as the diagonal splitting
+/// a quad, are left out. </summary>
+/// <param name="destination"> Receives the line list, two indices per edge. Must hold 2 * <paramref name="count"/> values. </param>
+/// <param name="indices"> The triangle list. </param>
+/// <param name="count"> The number of indices. </param>
+/// <param name="vertices"> The vertex positions, 3 floats per vertex. </param>
+/// <param name="creaseAngle"> The smallest angle between face normals that makes an edge, in radians. </param>
+/// <returns> The number of indices written to <paramref name="destination"/>. </returns>
+unsigned int extractEdges(unsigned int* destination, const unsigned int* indices, const unsigned int& count, const float* vertices, const float& creaseAngle);
+
+/// <summary> Marks which sides of each triangle are edges of the mesh. Bit 0 is the side from the first corner to the second,
+/// bit 1 the second to the third, and bit 2 the third back to the first. </summary>
+/// <param name="destination"> Receives one mask per triangle. Must hold <paramref name="count"/> / 3 values. </param>
+/// <param name="indices"> The triangle list. </param>
+/// <param name="count"> The number of indices. </param>
+/// <param name="edges"> The line list of the edges, in either direction. </param>
+/// <param name="edgeCount"> The number of indices in <paramref name="edges"/>. </param>
+void computeEdgeMasks(unsigned char* destination, const unsigned int* indices, const unsigned int& count, const unsigned int* edges, const unsigned int& edgeCount);
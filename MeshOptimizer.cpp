@@ -0,0 +1,232 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+float computeACMR(const unsigned int* indices, const unsigned int& count, const unsigned int& cacheSize) {
+	if (count < 3) {
+		return 0;
+	}
+	// A vertex is in the FIFO if it was added within the last cacheSize misses
+	unsigned int largest = 0;
+	for (unsigned int i = 0; i < count; ++i) {
+		largest = std::max(largest, indices[i]);
+	}
+	std::vector<unsigned int> addedAt(largest + 1, 0);
+	unsigned int misses = 0;
+	for (unsigned int i = 0; i < count; ++i) {
+		const unsigned int vertex = indices[i];
+		if (addedAt[vertex] == 0 || misses - addedAt[vertex] >= cacheSize) {
+			++misses;
+			addedAt[vertex] = misses;
+		}
+	}
+	return (float)misses / (count / 3);
+}
+
+namespace {
+	/// <summary> Pops dead-end vertices until one still has triangles left, then falls back to scanning in input order. </summary>
+	int skipDeadEnd(const std::vector<unsigned int>& liveTriangles, std::vector<unsigned int>& deadEnds, unsigned int& cursor) {
+		while (!deadEnds.empty()) {
+			const unsigned int vertex = deadEnds.back();
+			deadEnds.pop_back();
+			if (liveTriangles[vertex] > 0) {
+				return (int)vertex;
+			}
+		}
+		while (cursor < liveTriangles.size()) {
+			if (liveTriangles[cursor] > 0) {
+				return (int)cursor;
+			}
+			++cursor;
+		}
+		return -1;
+	}
+}
+
+void optimizeVertexCache(unsigned int* indices, const unsigned int& count, const unsigned int& numVertices, const unsigned int& cacheSize) {
+	const unsigned int numTriangles = count / 3;
+	if (numTriangles == 0) {
+		return;
+	}
+
+	// The triangles touching each vertex, as one array with an offset per vertex
+	std::vector<unsigned int> liveTriangles(numVertices, 0);
+	for (unsigned int i = 0; i < numTriangles * 3; ++i) {
+		++liveTriangles[indices[i]];
+	}
+	std::vector<unsigned int> offsets(numVertices + 1, 0);
+	for (unsigned int v = 0; v < numVertices; ++v) {
+		offsets[v + 1] = offsets[v] + liveTriangles[v];
+	}
+	std::vector<unsigned int> adjacency(numTriangles * 3);
+	std::vector<unsigned int> filled(offsets.begin(), offsets.end() - 1);
+	for (unsigned int t = 0; t < numTriangles; ++t) {
+		for (int corner = 0; corner < 3; ++corner) {
+			adjacency[filled[indices[t * 3 + corner]]++] = t;
+		}
+	}
+
+	std::vector<unsigned int> cacheTime(numVertices, 0);
+	std::vector<bool> emitted(numTriangles, false);
+	std::vector<unsigned int> deadEnds;
+	std::vector<unsigned int> candidates;
+	std::vector<unsigned int> output;
+	output.reserve(numTriangles * 3);
+	unsigned int time = cacheSize + 1;
+	unsigned int cursor = 0;
+
+	// Fan around one vertex at a time, emitting all of its remaining triangles, then move to the vertex
+	// that is most likely still cached and has the most triangles left
+	int fan = skipDeadEnd(liveTriangles, deadEnds, cursor);
+	while (fan >= 0) {
+		candidates.clear();
+		for (unsigned int a = offsets[fan]; a < offsets[fan + 1]; ++a) {
+			const unsigned int t = adjacency[a];
+			if (emitted[t]) {
+				continue;
+			}
+			for (int corner = 0; corner < 3; ++corner) {
+				const unsigned int vertex = indices[t * 3 + corner];
+				output.push_back(vertex);
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				--liveTriangles[vertex];
+				if (time - cacheTime[vertex] > cacheSize) {
+					cacheTime[vertex] = time++;
+				}
+			}
+			emitted[t] = true;
+		}
+
+		int best = -1, bestPriority = -1;
+		for (size_t i = 0; i < candidates.size(); ++i) {
+			const unsigned int vertex = candidates[i];
+			if (liveTriangles[vertex] == 0) {
+				continue;
+			}
+			// A vertex that will still be cached after fanning all its triangles is worth more the older it is,
+			// since it is about to be evicted; anything else only beats having no candidate
+			int priority = 0;
+			if (time - cacheTime[vertex] + 2 * liveTriangles[vertex] <= cacheSize) {
+				priority = (int)(time - cacheTime[vertex]);
+			}
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				best = (int)vertex;
+			}
+		}
+		fan = best >= 0 ? best : skipDeadEnd(liveTriangles, deadEnds, cursor);
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+void optimizeOverdraw(unsigned int* indices, const unsigned int& count, const float* vertices, const float& threshold, const unsigned int& cacheSize) {
+	const unsigned int numTriangles = count / 3;
+	if (numTriangles < 2) {
+		return;
+	}
+	const float target = computeACMR(indices, numTriangles * 3, cacheSize) * threshold;
+
+	// Clusters end where restarting from a cold cache has cost no more than the threshold allows
+	std::vector<unsigned int> clusterStarts(1, 0);
+	unsigned int clusterMisses = 0;
+	std::vector<unsigned int> cluster;
+	for (unsigned int t = 0; t < numTriangles; ++t) {
+		for (int corner = 0; corner < 3; ++corner) {
+			const unsigned int vertex = indices[t * 3 + corner];
+			const size_t start = cluster.size() > cacheSize ? cluster.size() - cacheSize : 0;
+			if (std::find(cluster.begin() + start, cluster.end(), vertex) == cluster.end()) {
+				cluster.push_back(vertex);
+				++clusterMisses;
+			}
+		}
+		const unsigned int clusterTriangles = t + 1 - clusterStarts.back();
+		if (clusterTriangles >= cacheSize && (float)clusterMisses / clusterTriangles <= target && t + 1 < numTriangles) {
+			clusterStarts.push_back(t + 1);
+			clusterMisses = 0;
+			cluster.clear();
+		}
+	}
+	clusterStarts.push_back(numTriangles);
+	const size_t clusters = clusterStarts.size() - 1;
+	if (clusters < 2) {
+		return;
+	}
+
+	// Clusters far out along their own facing direction tend to be in front of the rest of the mesh
+	float center[3] = { 0, 0, 0 };
+	for (unsigned int i = 0; i < numTriangles * 3; ++i) {
+		for (int axis = 0; axis < 3; ++axis) {
+			center[axis] += vertices[indices[i] * 3 + axis];
+		}
+	}
+	for (int axis = 0; axis < 3; ++axis) {
+		center[axis] /= numTriangles * 3;
+	}
+	std::vector<std::pair<float, size_t>> order(clusters);
+	for (size_t c = 0; c < clusters; ++c) {
+		float centroid[3] = { 0, 0, 0 }, normal[3] = { 0, 0, 0 };
+		for (unsigned int t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t) {
+			const float* a = vertices + indices[t * 3] * 3;
+			const float* b = vertices + indices[t * 3 + 1] * 3;
+			const float* d = vertices + indices[t * 3 + 2] * 3;
+			const float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+			const float ad[3] = { d[0] - a[0], d[1] - a[1], d[2] - a[2] };
+			// The cross product's length is twice the area, so larger triangles weigh more
+			normal[0] += ab[1] * ad[2] - ab[2] * ad[1];
+			normal[1] += ab[2] * ad[0] - ab[0] * ad[2];
+			normal[2] += ab[0] * ad[1] - ab[1] * ad[0];
+			for (int axis = 0; axis < 3; ++axis) {
+				centroid[axis] += a[axis] + b[axis] + d[axis];
+			}
+		}
+		const float corners = (float)(clusterStarts[c + 1] - clusterStarts[c]) * 3;
+		const float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		float potential = 0;
+		if (length > 0) {
+			for (int axis = 0; axis < 3; ++axis) {
+				potential += (centroid[axis] / corners - center[axis]) * normal[axis] / length;
+			}
+		}
+		order[c] = std::make_pair(-potential, c);
+	}
+	std::stable_sort(order.begin(), order.end());
+
+	std::vector<unsigned int> output;
+	output.reserve(numTriangles * 3);
+	for (size_t i = 0; i < clusters; ++i) {
+		const size_t c = order[i].second;
+		output.insert(output.end(), indices + clusterStarts[c] * 3, indices + clusterStarts[c + 1] * 3);
+	}
+	std::copy(output.begin(), output.end(), indices);
+}
+
+void optimizeVertexFetch(unsigned int* remap, unsigned int* const* indexLists, const unsigned int* counts, const unsigned int& lists, const unsigned int& numVertices) {
+	const unsigned int unassigned = ~0u;
+	std::fill(remap, remap + numVertices, unassigned);
+	unsigned int next = 0;
+	for (unsigned int list = 0; list < lists; ++list) {
+		for (unsigned int i = 0; i < counts[list]; ++i) {
+			unsigned int& vertex = indexLists[list][i];
+			if (remap[vertex] == unassigned) {
+				remap[vertex] = next++;
+			}
+			vertex = remap[vertex];
+		}
+	}
+	// Vertices no list uses go last, in their original order
+	for (unsigned int v = 0; v < numVertices; ++v) {
+		if (remap[v] == unassigned) {
+			remap[v] = next++;
+		}
+	}
+}
+
+void remapVertices(float* data, const unsigned int& components, const unsigned int* remap, const unsigned int& numVertices) {
+	std::vector<float> original(data, data + numVertices * components);
+	for (unsigned int v = 0; v < numVertices; ++v) {
+		std::copy(&original[v * components], &original[v * components] + components, data + remap[v] * components);
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+// Reordering passes for indexed triangle lists. They change the order triangles and vertices are stored in,
+// never the shape that is drawn, so they run once after a mesh is generated or loaded and before it is uploaded.
+
+/// <summary> The number of post-transform vertices the optimizations assume the GPU keeps around. </summary>
+static const unsigned int vertexCacheSize = 16;
+
+/// <summary> Average cache miss ratio: vertices transformed per triangle with a FIFO cache of <paramref name="cacheSize"/>.
+/// 3 is the worst possible, and well-ordered meshes get close to 0.5. </summary>
+/// <param name="indices"> The triangle list. </param>
+/// <param name="count"> The number of indices. </param>
+/// <param name="cacheSize"> The number of vertices the simulated cache holds. </param>
+float computeACMR(const unsigned int* indices, const unsigned int& count, const unsigned int& cacheSize = vertexCacheSize);
+
+/// <summary> Reorders triangles so that vertices are reused while they are still in the GPU's post-transform cache (Tipsify). </summary>
+/// <param name="indices"> The triangle list, reordered in place. </param>
+/// <param name="count"> The number of indices. </param>
+/// <param name="numVertices"> One more than the largest index. </param>
+/// <param name="cacheSize"> The number of vertices the cache holds. </param>
+void optimizeVertexCache(unsigned int* indices, const unsigned int& count, const unsigned int& numVertices, const unsigned int& cacheSize = vertexCacheSize);
+
+/// <summary> Splits a cache-optimized triangle list into clusters wherever the cache would be cold anyway, then draws the
+/// clusters most likely to hide the others first, to cut overdraw without losing much cache reuse. </summary>
+/// <param name="indices"> The triangle list, already passed through optimizeVertexCache(), reordered in place. </param>
+/// <param name="count"> The number of indices. </param>
+/// <param name="vertices"> The vertex positions, 3 floats per vertex. </param>
+/// <param name="threshold"> How much worse than the whole list a cluster's miss ratio may be before it is split. </param>
+/// <param name="cacheSize"> The number of vertices the cache holds. </param>
+void optimizeOverdraw(unsigned int* indices, const unsigned int& count, const float* vertices, const float& threshold = 1.05f, const unsigned int& cacheSize = vertexCacheSize);
+
+/// <summary> Numbers vertices in the order the index lists first use them, so the GPU fetches vertex memory front to back.
+/// Lists are visited in order, so vertices used only by later lists keep higher numbers than those used by earlier ones. </summary>
+/// <param name="remap"> Receives the new number of each vertex. Must hold <paramref name="numVertices"/> values. </param>
+/// <param name="indexLists"> The index lists, rewritten in place to use the new numbers. </param>
+/// <param name="counts"> The number of indices in each list. </param>
+/// <param name="lists"> The number of index lists. </param>
+/// <param name="numVertices"> The number of vertices. </param>
+void optimizeVertexFetch(unsigned int* remap, unsigned int* const* indexLists, const unsigned int* counts, const unsigned int& lists, const unsigned int& numVertices);
+
+/// <summary> Moves per-vertex data to the numbers given by optimizeVertexFetch(). </summary>
+/// <param name="data"> The per-vertex data, reordered in place. </param>
+/// <param name="components"> The number of floats per vertex. </param>
+/// <param name="remap"> The new number of each vertex. </param>
+/// <param name="numVertices"> The number of vertices. </param>
+void remapVertices(float* data, const unsigned int& components, const unsigned int* remap, const unsigned int& numVertices);
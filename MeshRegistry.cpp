@@ -0,0 +1,28 @@
+#include "MeshRegistry.h"
+
+std::vector<MeshRegistry::Mesh> MeshRegistry::meshes;
+
+MeshHandle MeshRegistry::create() {
+	// Value-initialized, so every count, pointer and GL name starts at zero
+	meshes.push_back(Mesh());
+	return MeshHandle((unsigned int)meshes.size() - 1);
+}
+
+unsigned int MeshRegistry::getCount() {
+	return (unsigned int)meshes.size();
+}
+
+unsigned int MeshRegistry::getVertexStride(const VertexLayout& layout) {
+	switch (layout) {
+	case QUANTIZED:
+		return 12;
+	case QUANTIZED_NORMALS:
+		return 16;
+	default:
+		return 28;
+	}
+}
+
+unsigned int MeshRegistry::getIndexSize(const unsigned int& numVertices) {
+	return numVertices <= 65536 ? sizeof(unsigned short) : sizeof(unsigned int);
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <GLAD/glad.h>
+#include <vector>
+
+/// <summary> Identifies a mesh in the MeshRegistry. As cheap to copy and compare as the index it wraps. </summary>
+struct MeshHandle {
+	unsigned int index;
+
+	/// <summary> A handle to no mesh. </summary>
+	MeshHandle() : index(~0u) {}
+	explicit MeshHandle(const unsigned int& index) : index(index) {}
+
+	/// <summary> Returns whether this handle refers to a mesh. </summary>
+	bool isValid() const { return index != ~0u; }
+	bool operator==(const MeshHandle& other) const { return index == other.index; }
+	bool operator!=(const MeshHandle& other) const { return index != other.index; }
+};
+
+/// <summary>
+/// Every mesh the shapes draw, as plain records in one flat array. A shape only holds a MeshHandle, so culling, level of
+/// detail and drawing read the record directly instead of asking the shape's class for each value, and any number of
+/// meshes can be drawn by shapes of the same class.
+///
+/// A record holds the source data until the mesh is uploaded, then the GL objects and the index range of each level
+/// of detail. Every level and the edges share one index buffer, so a mesh is drawn with a single VAO and no element
+/// buffer binds.
+/// </summary>
+class MeshRegistry {
+public:
+	/// <summary> How vertex data is stored on the GPU. </summary>
+	enum VertexLayout {
+		/// <summary> Float position and RGBA color, 28 bytes per vertex. </summary>
+		FULL_PRECISION,
+		/// <summary> snorm16 position relative to the mesh radius and RGBA8 color, 12 bytes per vertex. </summary>
+		QUANTIZED,
+		/// <summary> QUANTIZED plus a 2_10_10_10 normal, 16 bytes per vertex. </summary>
+		QUANTIZED_NORMALS
+	};
+
+	/// <summary> One mesh. Every field can be modified directly until the mesh is uploaded. </summary>
+	struct Mesh {
+		// Source data, read when the mesh is uploaded
+
+		unsigned int numVertices;
+		/// <summary> Positions, 3 floats per vertex. </summary>
+		float* vertices;
+		/// <summary> Face colors, 4 floats per vertex. </summary>
+		float* colors;
+		/// <summary> Edge colors, 4 floats per vertex, or nullptr for none. </summary>
+		float* edgeColors;
+		/// <summary> The triangle list of each level of detail, coarsest first. </summary>
+		unsigned int** triangles;
+		/// <summary> The line list of the edges, or nullptr for none. Meshes without authored edges can find theirs with extractEdges(). </summary>
+		unsigned int* edges;
+		/// <summary> Vertices already packed in layout, uploaded instead of vertices and colors when set. </summary>
+		const unsigned char* packedVertices;
+		/// <summary> Each level's indices already at the uploaded index size, used instead of triangles when set. </summary>
+		const unsigned char** packedTriangles;
+
+		// Levels of detail
+
+		/// <summary> The finest level. There are maxLOD + 1 levels. </summary>
+		char maxLOD;
+		/// <summary> The number of indices of each level. </summary>
+		unsigned int* numTriangleVertices;
+		/// <summary> For each level, the farthest its surface strays from the shape it approximates, in model units. </summary>
+		float* lodErrors;
+		unsigned int numEdgeVertices;
+
+		// Bounds
+
+		/// <summary> The distance from the model origin to the farthest vertex. </summary>
+		float radius;
+		/// <summary> The radius of the largest sphere around the model origin that every level contains,
+		/// or 0 if the mesh should never hide anything behind it. </summary>
+		float innerRadius;
+		/// <summary> Whether the mesh approximates a sphere of radius around the model origin, so it can be drawn as an impostor. </summary>
+		bool sphere;
+
+		// GL objects and ranges, set by the upload
+
+		/// <summary> Whether the mesh can be drawn: its buffers are filled and its VAOs made. </summary>
+		bool buffered;
+		/// <summary> Whether a ResourceLoader is uploading the mesh. Its source data must not be modified until it is done. </summary>
+		bool loading;
+		VertexLayout layout;
+		unsigned int vertexBuffer;
+		unsigned int edgeColorsBuffer;
+		/// <summary> Every level's triangles, then the edges. </summary>
+		unsigned int indexBuffer;
+		unsigned int facesVAO;
+		unsigned int edgesVAO;
+		GLenum indexType;
+		unsigned int indexSize;
+		/// <summary> Where each level starts in indexBuffer, in indices. </summary>
+		unsigned int* firstIndex;
+		unsigned int firstEdgeIndex;
+		/// <summary> For each triangle in indexBuffer, which of its sides are edges, see computeEdgeMasks().
+		/// Only made when the mesh has edges. </summary>
+		unsigned int edgeMaskBuffer;
+		/// <summary> A buffer texture reading edgeMaskBuffer, for the barycentric edge program. </summary>
+		unsigned int edgeMaskTexture;
+	};
+
+	/// <summary> Adds an empty mesh. References from get() may move, so fetch them again after calling this. </summary>
+	/// <returns> The new mesh's handle. </returns>
+	static MeshHandle create();
+
+	/// <summary> Returns the mesh <paramref name="handle"/> refers to. Defined here so the render loop can inline it. </summary>
+	static Mesh& get(const MeshHandle& handle) {
+		return meshes[handle.index];
+	}
+
+	/// <summary> Returns the number of meshes. </summary>
+	static unsigned int getCount();
+
+	/// <summary> Returns the bytes per vertex of <paramref name="layout"/>. </summary>
+	static unsigned int getVertexStride(const VertexLayout& layout);
+
+	/// <summary> Returns the bytes per uploaded index for a mesh of <paramref name="numVertices"/> vertices:
+	/// 2 when every vertex can be reached with 16 bits, 4 otherwise. </summary>
+	static unsigned int getIndexSize(const unsigned int& numVertices);
+
+private:
+	static std::vector<Mesh> meshes;
+};
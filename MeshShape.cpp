@@ -0,0 +1,420 @@
+#include "MeshShape.h"
+#include <cfloat>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+using std::cout; using std::endl;
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+std::map<string, MeshShape::Asset*> MeshShape::assets;
+
+namespace {
+	/// <summary> Frees the CPU copies of a mesh built for convert(), which is never uploaded. </summary>
+	void releaseSource(MeshRegistry::Mesh& mesh) {
+		for (int lod = 0; lod <= mesh.maxLOD; ++lod) {
+			delete[] mesh.triangles[lod];
+		}
+		delete[] mesh.triangles;
+		delete[] mesh.numTriangleVertices;
+		delete[] mesh.lodErrors;
+		delete[] mesh.edges;
+		delete[] mesh.vertices;
+		delete[] mesh.colors;
+		mesh = MeshRegistry::Mesh();
+	}
+
+	/// <summary> Rounds <paramref name="offset"/> up to the next block boundary. </summary>
+	unsigned long long alignBlock(const unsigned long long& offset) {
+		return (offset + MeshShape::blockAlignment - 1) / MeshShape::blockAlignment * MeshShape::blockAlignment;
+	}
+
+	double dot(const double* a, const double* b) {
+		return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+	}
+
+	/// <summary> The squared distance from the origin to the closest point of a triangle (Ericson, Real-Time Collision Detection 5.1.5). </summary>
+	double originDistanceSquared(const float* pa, const float* pb, const float* pc) {
+		const double a[3] = { pa[0], pa[1], pa[2] };
+		const double b[3] = { pb[0], pb[1], pb[2] };
+		const double c[3] = { pc[0], pc[1], pc[2] };
+		const double ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		const double ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		const double ap[3] = { -a[0], -a[1], -a[2] };
+		const double bp[3] = { -b[0], -b[1], -b[2] };
+		const double cp[3] = { -c[0], -c[1], -c[2] };
+
+		const double d1 = dot(ab, ap), d2 = dot(ac, ap);
+		if (d1 <= 0 && d2 <= 0) {
+			return dot(a, a);
+		}
+		const double d3 = dot(ab, bp), d4 = dot(ac, bp);
+		if (d3 >= 0 && d4 <= d3) {
+			return dot(b, b);
+		}
+		double closest[3];
+		const double vc = d1 * d4 - d3 * d2;
+		if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+			const double v = d1 / (d1 - d3);
+			for (int axis = 0; axis < 3; ++axis) {
+				closest[axis] = a[axis] + v * ab[axis];
+			}
+			return dot(closest, closest);
+		}
+		const double d5 = dot(ab, cp), d6 = dot(ac, cp);
+		if (d6 >= 0 && d5 <= d6) {
+			return dot(c, c);
+		}
+		const double vb = d5 * d2 - d1 * d6;
+		if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+			const double w = d2 / (d2 - d6);
+			for (int axis = 0; axis < 3; ++axis) {
+				closest[axis] = a[axis] + w * ac[axis];
+			}
+			return dot(closest, closest);
+		}
+		const double va = d3 * d6 - d5 * d4;
+		if (va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0) {
+			const double w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+			for (int axis = 0; axis < 3; ++axis) {
+				closest[axis] = b[axis] + w * (c[axis] - b[axis]);
+			}
+			return dot(closest, closest);
+		}
+		const double denominator = 1 / (va + vb + vc);
+		const double v = vb * denominator, w = vc * denominator;
+		for (int axis = 0; axis < 3; ++axis) {
+			closest[axis] = a[axis] + ab[axis] * v + ac[axis] * w;
+		}
+		return dot(closest, closest);
+	}
+}
+
+MeshShape::MeshShape(const string& path, const float& x, const float& y, const float& z, const float& sx, const float& sy, const float& sz, const float& rx, const float& ry, const float& rz) {
+	this->x = x;
+	this->y = y;
+	this->z = z;
+	this->sx = sx;
+	this->sy = sy;
+	this->sz = sz;
+	this->rx = rx;
+	this->ry = ry;
+	this->rz = rz;
+	this->currentLOD = 0;
+
+	std::map<string, Asset*>::iterator found = assets.find(path);
+	if (found == assets.end()) {
+		Asset* loaded = new Asset();
+		if (!load(path, *loaded)) {
+			delete loaded;
+			cout << "Unable to load mesh at path: " << path << endl;
+			throw std::runtime_error("Unable to load mesh.");
+		}
+		found = assets.insert(std::make_pair(path, loaded)).first;
+	}
+	asset = found->second;
+	mesh = asset->mesh;
+}
+
+MeshShape::MeshShape() {
+	asset = nullptr;
+	mesh = MeshRegistry::create();
+}
+
+bool MeshShape::load(const string& path, Asset& asset) {
+	if (!asset.file.open(path) || asset.file.getSize() < sizeof(Header)) {
+		return false;
+	}
+	const unsigned char* data = asset.file.getData();
+	const unsigned long long size = asset.file.getSize();
+	const Header* header = (const Header*)data;
+
+	// Check every block fits before trusting the counts. The blocks themselves are not hashed, which would mean reading all of them.
+	const unsigned int indexSize = MeshRegistry::getIndexSize(header->numVertices);
+	if (header->magic != magic || header->version != version || header->layout > MeshRegistry::QUANTIZED_NORMALS || header->indexSize != indexSize
+		|| header->lods == 0 || header->lods > 64) {
+		return false;
+	}
+	const unsigned long long vertexBytes = (unsigned long long)header->numVertices * MeshRegistry::getVertexStride((MeshRegistry::VertexLayout)header->layout);
+	if (header->vertexBytes != vertexBytes || header->vertexOffset > size || vertexBytes > size - header->vertexOffset
+		|| header->lodOffset > size || header->lods * sizeof(LOD) > size - header->lodOffset) {
+		return false;
+	}
+	if (header->edgeOffset > size || (unsigned long long)header->numEdgeVertices * indexSize > size - header->edgeOffset) {
+		return false;
+	}
+	const LOD* table = (const LOD*)(data + header->lodOffset);
+	for (unsigned int lod = 0; lod < header->lods; ++lod) {
+		if (table[lod].indexOffset > size || (unsigned long long)table[lod].numIndices * indexSize > size - table[lod].indexOffset) {
+			return false;
+		}
+	}
+
+	asset.header = header;
+	asset.mesh = MeshRegistry::create();
+	MeshRegistry::Mesh& mesh = MeshRegistry::get(asset.mesh);
+	mesh.numVertices = header->numVertices;
+	mesh.packedVertices = data + header->vertexOffset;
+	mesh.layout = (MeshRegistry::VertexLayout)header->layout;
+	mesh.radius = header->radius;
+	mesh.innerRadius = header->innerRadius;
+	mesh.maxLOD = (char)(header->lods - 1);
+	mesh.numTriangleVertices = new unsigned int[header->lods];
+	mesh.lodErrors = new float[header->lods];
+	mesh.packedTriangles = new const unsigned char*[header->lods];
+	for (unsigned int lod = 0; lod < header->lods; ++lod) {
+		mesh.numTriangleVertices[lod] = table[lod].numIndices;
+		mesh.lodErrors[lod] = table[lod].error;
+		mesh.packedTriangles[lod] = data + table[lod].indexOffset;
+	}
+	mesh.numEdgeVertices = header->numEdgeVertices;
+	mesh.edges = new unsigned int[header->numEdgeVertices];
+	for (unsigned int i = 0; i < header->numEdgeVertices; ++i) {
+		mesh.edges[i] = indexSize == sizeof(unsigned short) ? ((const unsigned short*)(data + header->edgeOffset))[i]
+			: ((const unsigned int*)(data + header->edgeOffset))[i];
+	}
+	return true;
+}
+
+bool MeshShape::convert(const string& objPath, const string& meshPath, const MeshRegistry::VertexLayout& layout, const float& creaseAngle) {
+	MeshShape builder;
+	if (!builder.readObj(objPath)) {
+		return false;
+	}
+	MeshRegistry::Mesh& built = MeshRegistry::get(builder.mesh);
+
+	// Halve the triangles for each coarser level, while the levels still have enough to be worth drawing
+	const unsigned int minimumTriangles = 16;
+	const unsigned int triangles = built.numTriangleVertices[0] / 3;
+	float ratios[16];
+	int levels = 0;
+	for (float ratio = 0.5f; levels < 16 && triangles * ratio >= minimumTriangles; ratio *= 0.5f) {
+		ratios[levels++] = ratio;
+	}
+	builder.generateLODs(ratios, levels);
+	builder.extractEdges(creaseAngle);
+	builder.optimizeMesh(objPath);
+
+	Header header = {};
+	header.magic = magic;
+	header.version = version;
+	header.numVertices = built.numVertices;
+	header.lods = built.maxLOD + 1;
+	header.layout = layout;
+	header.indexSize = MeshRegistry::getIndexSize(built.numVertices);
+	float radiusSquared = 0;
+	for (int axis = 0; axis < 3; ++axis) {
+		header.boundsMin[axis] = FLT_MAX;
+		header.boundsMax[axis] = -FLT_MAX;
+	}
+	for (unsigned int i = 0; i < built.numVertices; ++i) {
+		const float* vertex = built.vertices + i * 3;
+		for (int axis = 0; axis < 3; ++axis) {
+			header.boundsMin[axis] = fminf(header.boundsMin[axis], vertex[axis]);
+			header.boundsMax[axis] = fmaxf(header.boundsMax[axis], vertex[axis]);
+		}
+		radiusSquared = fmaxf(radiusSquared, vertex[0] * vertex[0] + vertex[1] * vertex[1] + vertex[2] * vertex[2]);
+	}
+	header.radius = sqrtf(radiusSquared);
+	header.innerRadius = builder.computeInnerRadius();
+
+	// packVertex() reads the layout and radius from the mesh
+	built.layout = layout;
+	built.radius = header.radius;
+	const unsigned int stride = MeshRegistry::getVertexStride(layout);
+	header.vertexBytes = (unsigned long long)stride * built.numVertices;
+	std::vector<unsigned char> vertexBlock((size_t)header.vertexBytes);
+	for (unsigned int i = 0; i < built.numVertices; ++i) {
+		packVertex(built, i, &vertexBlock[(size_t)i * stride]);
+	}
+
+	std::vector<LOD> table(header.lods);
+	header.vertexOffset = alignBlock(sizeof(Header));
+	header.lodOffset = alignBlock(header.vertexOffset + header.vertexBytes);
+	unsigned long long offset = alignBlock(header.lodOffset + sizeof(LOD) * header.lods);
+	for (unsigned int lod = 0; lod < header.lods; ++lod) {
+		table[lod].indexOffset = offset;
+		table[lod].numIndices = built.numTriangleVertices[lod];
+		table[lod].error = built.lodErrors[lod];
+		offset = alignBlock(offset + (unsigned long long)table[lod].numIndices * header.indexSize);
+	}
+	header.edgeOffset = offset;
+	header.numEdgeVertices = built.numEdgeVertices;
+	header.creaseAngle = creaseAngle;
+
+	// Write beside the real file and swap it in, so a process that has the old asset mapped keeps its pages, and a
+	// failed write never leaves a file that load() would accept
+	const string temporary = meshPath + ".tmp";
+	std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+	if (!out.is_open()) {
+		releaseSource(built);
+		cout << "Unable to write mesh at path: " << meshPath << endl;
+		return false;
+	}
+	const char padding[blockAlignment] = {};
+	unsigned long long written = 0;
+	// Pads up to the next block, then writes one
+	auto writeBlock = [&](const unsigned long long& at, const void* block, const unsigned long long& bytes) {
+		out.write(padding, (std::streamsize)(at - written));
+		out.write((const char*)block, (std::streamsize)bytes);
+		written = at + bytes;
+	};
+	writeBlock(0, &header, sizeof(Header));
+	writeBlock(header.vertexOffset, vertexBlock.data(), header.vertexBytes);
+	writeBlock(header.lodOffset, table.data(), sizeof(LOD) * header.lods);
+	std::vector<unsigned short> narrow;
+	auto writeIndices = [&](const unsigned long long& at, const unsigned int* indices, const unsigned int& count) {
+		if (header.indexSize == sizeof(unsigned short)) {
+			narrow.assign(indices, indices + count);
+			writeBlock(at, narrow.data(), narrow.size() * sizeof(unsigned short));
+		}
+		else {
+			writeBlock(at, indices, (unsigned long long)count * sizeof(unsigned int));
+		}
+	};
+	for (unsigned int lod = 0; lod < header.lods; ++lod) {
+		writeIndices(table[lod].indexOffset, built.triangles[lod], table[lod].numIndices);
+	}
+	writeIndices(header.edgeOffset, built.edges, header.numEdgeVertices);
+	out.close();
+	releaseSource(built);
+	if (out.fail()) {
+		cout << "Unable to write mesh at path: " << meshPath << endl;
+		std::remove(temporary.c_str());
+		return false;
+	}
+#ifdef _WIN32
+	if (!MoveFileExA(temporary.c_str(), meshPath.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+#else
+	if (std::rename(temporary.c_str(), meshPath.c_str()) != 0) {
+#endif
+		cout << "Unable to write mesh at path: " << meshPath << endl;
+		std::remove(temporary.c_str());
+		return false;
+	}
+	cout << "Wrote " << meshPath << ": " << header.numVertices << " vertices, " << triangles << " triangles, " << header.lods << " levels of detail, " << header.numEdgeVertices / 2 << " edges" << endl;
+	return true;
+}
+
+bool MeshShape::readObj(const string& path) {
+	std::ifstream in(path);
+	if (!in.is_open()) {
+		cout << "Unable to open OBJ at path: " << path << endl;
+		return false;
+	}
+	std::vector<float> positions, colors;
+	std::vector<unsigned int> indices;
+	std::vector<unsigned int> face;
+	string line, type, corner;
+	while (std::getline(in, line)) {
+		std::istringstream stream(line);
+		type.clear();
+		stream >> type;
+		if (type == "v") {
+			float position[3] = { 0, 0, 0 }, color[3] = { 1, 1, 1 };
+			stream >> position[0] >> position[1] >> position[2];
+			// Some exporters append an RGB color to each position
+			float rgb[3];
+			if (stream >> rgb[0] >> rgb[1] >> rgb[2]) {
+				color[0] = rgb[0];
+				color[1] = rgb[1];
+				color[2] = rgb[2];
+			}
+			positions.insert(positions.end(), position, position + 3);
+			colors.insert(colors.end(), color, color + 3);
+			colors.push_back(1);
+		}
+		else if (type == "f") {
+			face.clear();
+			const long defined = (long)(positions.size() / 3);
+			while (stream >> corner) {
+				// "v", "v/vt", "v//vn" and "v/vt/vn" all start with the position, and negative positions count back from the last one
+				long index = strtol(corner.c_str(), nullptr, 10);
+				if (index < 0) {
+					index += defined + 1;
+				}
+				if (index < 1 || index > defined) {
+					cout << "Invalid face in OBJ at path: " << path << ": " << line << endl;
+					return false;
+				}
+				face.push_back((unsigned int)(index - 1));
+			}
+			// Polygons become fans around their first corner
+			for (size_t i = 2; i < face.size(); ++i) {
+				if (face[0] != face[i - 1] && face[i - 1] != face[i] && face[i] != face[0]) {
+					indices.push_back(face[0]);
+					indices.push_back(face[i - 1]);
+					indices.push_back(face[i]);
+				}
+			}
+		}
+	}
+	if (indices.empty()) {
+		cout << "No faces in OBJ at path: " << path << endl;
+		return false;
+	}
+
+	MeshRegistry::Mesh& data = MeshRegistry::get(mesh);
+	data.numVertices = (unsigned int)(positions.size() / 3);
+	data.vertices = new float[positions.size()];
+	std::copy(positions.begin(), positions.end(), data.vertices);
+	data.colors = new float[colors.size()];
+	std::copy(colors.begin(), colors.end(), data.colors);
+	data.maxLOD = 0;
+	data.numTriangleVertices = new unsigned int[1];
+	data.numTriangleVertices[0] = (unsigned int)indices.size();
+	data.triangles = new unsigned int*[1];
+	data.triangles[0] = new unsigned int[indices.size()];
+	std::copy(indices.begin(), indices.end(), data.triangles[0]);
+	return true;
+}
+
+float MeshShape::computeInnerRadius() const {
+	// The origin is inside a closed mesh when the mesh winds around it, which is when the signed solid angles
+	// of its triangles, seen from the origin, add up to a whole sphere (Van Oosterom and Strackee)
+	const MeshRegistry::Mesh& data = MeshRegistry::get(mesh);
+	const float* vertices = data.vertices;
+	const unsigned int* finest = data.triangles[(int)data.maxLOD];
+	double solidAngle = 0;
+	for (unsigned int i = 0; i < data.numTriangleVertices[(int)data.maxLOD]; i += 3) {
+		const float* pa = vertices + finest[i] * 3;
+		const float* pb = vertices + finest[i + 1] * 3;
+		const float* pc = vertices + finest[i + 2] * 3;
+		const double a[3] = { pa[0], pa[1], pa[2] };
+		const double b[3] = { pb[0], pb[1], pb[2] };
+		const double c[3] = { pc[0], pc[1], pc[2] };
+		const double bc[3] = { b[1] * c[2] - b[2] * c[1], b[2] * c[0] - b[0] * c[2], b[0] * c[1] - b[1] * c[0] };
+		const double la = sqrt(dot(a, a)), lb = sqrt(dot(b, b)), lc = sqrt(dot(c, c));
+		solidAngle += 2 * atan2(dot(a, bc), la * lb * lc + dot(a, b) * lc + dot(a, c) * lb + dot(b, c) * la);
+	}
+	// A winding number of at least one half, which is 2 pi steradians
+	if (fabs(solidAngle) < 6.283185307179586) {
+		return 0;
+	}
+
+	// Each level is a different surface, and the sphere has to fit inside all of them
+	double nearest = DBL_MAX;
+	for (int lod = 0; lod <= data.maxLOD; ++lod) {
+		const unsigned int* indices = data.triangles[lod];
+		for (unsigned int i = 0; i < data.numTriangleVertices[lod]; i += 3) {
+			const double distance = originDistanceSquared(vertices + indices[i] * 3, vertices + indices[i + 1] * 3, vertices + indices[i + 2] * 3);
+			if (distance < nearest) {
+				nearest = distance;
+			}
+		}
+	}
+	return (float)sqrt(nearest);
+}
+
+Vector MeshShape::getBoundsMin() const {
+	return Vector(asset->header->boundsMin);
+}
+
+Vector MeshShape::getBoundsMax() const {
+	return Vector(asset->header->boundsMax);
+}
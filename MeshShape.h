@@ -0,0 +1,115 @@
+#pragma once
+#include "GraphicsShape.h"
+#include "MappedFile.h"
+#include <map>
+
+/// <summary>
+/// A child of GraphicsShape drawing a mesh loaded from an asset file, so shapes are not limited to the generated ones.
+///
+/// Asset files are written by convert() and hold the vertices already packed in a GPU vertex layout, the indices of
+/// every level of detail and of the edges already at the width they are drawn with, a table of those levels, and the
+/// bounds of the mesh.
+/// Each block starts on a blockAlignment boundary. Loading maps the file and checks that the blocks fit, and uploading
+/// hands the mapped blocks straight to GL, so nothing is parsed or copied along the way.
+///
+/// Every shape made from the same path shares one loaded mesh and its buffers, so they are drawn together.
+/// </summary>
+class MeshShape : public GraphicsShape {
+public:
+	/// <summary> The boundary every block in an asset file starts on, in bytes. </summary>
+	static const unsigned int blockAlignment = 64;
+
+	/// <summary> MeshShape constructor. Loads the asset the first time <paramref name="path"/> is used. </summary>
+	/// <param name="path"> The path to the asset file. </param>
+	/// <param name="x"> The x-coord of this shape. </param>
+	/// <param name="y"> The y-coord of this shape. </param>
+	/// <param name="z"> The z-coord of this shape. </param>
+	/// <param name="sx"> The x-scale of this shape. </param>
+	/// <param name="sy"> The y-scale of this shape. </param>
+	/// <param name="sz"> The z-scale of this shape. </param>
+	/// <param name="rx"> The x-rotation of this shape, in radians. </param>
+	/// <param name="ry"> The y-rotation of this shape, in radians. </param>
+	/// <param name="rz"> The z-rotation of this shape, in radians. </param>
+	MeshShape(const string& path, const float& x = 0, const float& y = 0, const float& z = 0, const float& sx = 1, const float& sy = 1, const float& sz = 1, const float& rx = 0, const float& ry = 0, const float& rz = 0);
+
+	/// <summary> Converts a Wavefront OBJ file to an asset file. Faces are split into triangles, coarser levels of detail are
+	/// generated by simplification, edges are extracted at creases, and every level is optimized for the vertex cache.
+	/// Texture coordinates and normals are ignored. Vertex colors are read when given after the position, and are white otherwise. </summary>
+	/// <param name="objPath"> The OBJ file to read. </param>
+	/// <param name="meshPath"> The asset file to write. </param>
+	/// <param name="layout"> The vertex layout to store the vertices in. </param>
+	/// <param name="creaseAngle"> The smallest angle between faces that makes an edge, in radians. 30 degrees by default. </param>
+	/// <returns> Whether the asset file was written. </returns>
+	static bool convert(const string& objPath, const string& meshPath, const MeshRegistry::VertexLayout& layout = MeshRegistry::QUANTIZED,
+		const float& creaseAngle = 0.5235988f);
+
+	/// <summary> Returns the corner of this shape's unscaled mesh with the lowest coordinates. </summary>
+	Vector getBoundsMin() const;
+	/// <summary> Returns the corner of this shape's unscaled mesh with the highest coordinates. </summary>
+	Vector getBoundsMax() const;
+
+private:
+	/// <summary> The start of every asset file. </summary>
+	struct Header {
+		unsigned int magic;
+		unsigned int version;
+		unsigned int numVertices;
+		unsigned int lods;
+		/// <summary> The VertexLayout the vertex block is packed in. </summary>
+		unsigned int layout;
+		/// <summary> The bytes per index: 2 when every vertex fits in 16 bits, 4 otherwise. </summary>
+		unsigned int indexSize;
+		float boundsMin[3];
+		float boundsMax[3];
+		float radius;
+		float innerRadius;
+		unsigned long long vertexOffset;
+		unsigned long long vertexBytes;
+		/// <summary> The offset of the LOD table, which has one entry per level, coarsest first. </summary>
+		unsigned long long lodOffset;
+		/// <summary> The offset of the edge list, at indexSize bytes per index. </summary>
+		unsigned long long edgeOffset;
+		unsigned int numEdgeVertices;
+		/// <summary> The angle the edges were extracted at, in radians. </summary>
+		float creaseAngle;
+	};
+
+	/// <summary> An entry of the LOD table. </summary>
+	struct LOD {
+		unsigned long long indexOffset;
+		unsigned int numIndices;
+		float error;
+	};
+
+	static const unsigned int magic = 0x4148534D; // "MSHA"
+	static const unsigned int version = 2;
+
+	/// <summary> A loaded asset file. Its mesh points into the mapping, so the file stays mapped. Only the edges are copied,
+	/// since the edge masks are worked out from them when the mesh is uploaded. </summary>
+	struct Asset {
+		MappedFile file;
+		const Header* header;
+		MeshHandle mesh;
+	};
+
+	/// <summary> The loaded assets, by path. Never unloaded, since shapes may be made from them at any time. </summary>
+	static std::map<string, Asset*> assets;
+
+	const Asset* asset;
+
+	/// <summary> Makes a shape drawing a new, empty mesh, for convert() to fill. </summary>
+	MeshShape();
+
+	/// <summary> Maps an asset file and checks that its header and blocks agree with each other and the file size. </summary>
+	/// <param name="path"> The path to the asset file. </param>
+	/// <param name="asset"> The asset to load into. Its mesh is only created if the file can be used. </param>
+	/// <returns> Whether the file could be used. </returns>
+	static bool load(const string& path, Asset& asset);
+
+	/// <summary> Reads the positions, colors and triangles of an OBJ file into the mesh of this shape. </summary>
+	bool readObj(const string& path);
+
+	/// <summary> Returns the radius of the largest sphere around the model origin inside every level of detail,
+	/// or 0 when the origin is outside the mesh. </summary>
+	float computeInnerRadius() const;
+};
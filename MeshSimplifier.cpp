@@ -0,0 +1,290 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+	/// <summary> A sum of squared distances to planes, as the upper triangle of a symmetric 4x4 matrix, and the total weight of the planes. </summary>
+	struct Quadric {
+		double xx, xy, xz, xw, yy, yz, yw, zz, zw, ww, weight;
+	};
+
+	void addPlane(Quadric& q, const double& a, const double& b, const double& c, const double& d, const double& weight) {
+		q.xx += weight * a * a;
+		q.xy += weight * a * b;
+		q.xz += weight * a * c;
+		q.xw += weight * a * d;
+		q.yy += weight * b * b;
+		q.yz += weight * b * c;
+		q.yw += weight * b * d;
+		q.zz += weight * c * c;
+		q.zw += weight * c * d;
+		q.ww += weight * d * d;
+		q.weight += weight;
+	}
+
+	void addQuadric(Quadric& q, const Quadric& other) {
+		q.xx += other.xx;
+		q.xy += other.xy;
+		q.xz += other.xz;
+		q.xw += other.xw;
+		q.yy += other.yy;
+		q.yz += other.yz;
+		q.yw += other.yw;
+		q.zz += other.zz;
+		q.zw += other.zw;
+		q.ww += other.ww;
+		q.weight += other.weight;
+	}
+
+	/// <summary> The weighted mean squared distance from <paramref name="p"/> to the planes of <paramref name="q"/>. </summary>
+	double evaluate(const Quadric& q, const float* p) {
+		const double x = p[0], y = p[1], z = p[2];
+		const double sum = q.xx * x * x + q.yy * y * y + q.zz * z * z + q.ww
+			+ 2 * (q.xy * x * y + q.xz * x * z + q.yz * y * z + q.xw * x + q.yw * y + q.zw * z);
+		return q.weight > 0 ? fabs(sum) / q.weight : 0;
+	}
+
+	void cross(const float* a, const float* b, const float* c, double* out) {
+		const double ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		const double ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		out[0] = ab[1] * ac[2] - ab[2] * ac[1];
+		out[1] = ab[2] * ac[0] - ab[0] * ac[2];
+		out[2] = ab[0] * ac[1] - ab[1] * ac[0];
+	}
+
+	unsigned long long edgeKey(const unsigned int& from, const unsigned int& to) {
+		return (unsigned long long)from << 32 | to;
+	}
+
+	/// <summary> A candidate half-edge collapse, moving vertex from onto vertex to. </summary>
+	struct Collapse {
+		double cost;
+		double error;
+		unsigned int from;
+		unsigned int to;
+
+		bool operator<(const Collapse& other) const {
+			return cost < other.cost;
+		}
+	};
+
+	/// <summary> Open edges pull much harder than faces, so the outline of the mesh stays put. </summary>
+	const double boundaryWeight = 10;
+}
+
+unsigned int simplifyMesh(unsigned int* destination, const unsigned int* indices, const unsigned int& count, const float* vertices, const unsigned int& numVertices,
+	const unsigned int& targetCount, float& error, const float* attributes, const unsigned int& attributeComponents, const float& attributeWeight) {
+	std::vector<unsigned int> current(indices, indices + count / 3 * 3);
+	error = 0;
+
+	// Each vertex starts with the planes of the triangles around it, weighted by area so slivers count for little
+	std::vector<Quadric> quadrics(numVertices, Quadric());
+	for (size_t t = 0; t < current.size(); t += 3) {
+		const unsigned int* corners = &current[t];
+		double normal[3];
+		cross(vertices + corners[0] * 3, vertices + corners[1] * 3, vertices + corners[2] * 3, normal);
+		const double length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		if (length == 0) {
+			continue;
+		}
+		const double a = normal[0] / length, b = normal[1] / length, c = normal[2] / length;
+		const float* p = vertices + corners[0] * 3;
+		const double d = -(a * p[0] + b * p[1] + c * p[2]);
+		for (int corner = 0; corner < 3; ++corner) {
+			addPlane(quadrics[corners[corner]], a, b, c, d, length * 0.5);
+		}
+	}
+
+	// An edge is open when no triangle runs along it the other way. Each gets a plane through it, perpendicular
+	// to its triangle, which makes moving its ends off the outline expensive.
+	std::vector<unsigned long long> directed(current.size());
+	for (size_t t = 0; t < current.size(); t += 3) {
+		for (int corner = 0; corner < 3; ++corner) {
+			directed[t + corner] = edgeKey(current[t + corner], current[t + (corner + 1) % 3]);
+		}
+	}
+	std::sort(directed.begin(), directed.end());
+	std::vector<bool> onBoundary(numVertices, false);
+	std::vector<unsigned long long> boundaryEdges;
+	for (size_t t = 0; t < current.size(); t += 3) {
+		const unsigned int* corners = &current[t];
+		double normal[3];
+		cross(vertices + corners[0] * 3, vertices + corners[1] * 3, vertices + corners[2] * 3, normal);
+		for (int corner = 0; corner < 3; ++corner) {
+			const unsigned int from = corners[corner], to = corners[(corner + 1) % 3];
+			if (std::binary_search(directed.begin(), directed.end(), edgeKey(to, from))) {
+				continue;
+			}
+			onBoundary[from] = onBoundary[to] = true;
+			boundaryEdges.push_back(edgeKey(std::min(from, to), std::max(from, to)));
+
+			const float* p = vertices + from * 3;
+			const float* q = vertices + to * 3;
+			const double edge[3] = { q[0] - p[0], q[1] - p[1], q[2] - p[2] };
+			double plane[3] = {
+				edge[1] * normal[2] - edge[2] * normal[1],
+				edge[2] * normal[0] - edge[0] * normal[2],
+				edge[0] * normal[1] - edge[1] * normal[0]
+			};
+			const double length = sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+			if (length == 0) {
+				continue;
+			}
+			for (int axis = 0; axis < 3; ++axis) {
+				plane[axis] /= length;
+			}
+			const double d = -(plane[0] * p[0] + plane[1] * p[1] + plane[2] * p[2]);
+			const double weight = boundaryWeight * (edge[0] * edge[0] + edge[1] * edge[1] + edge[2] * edge[2]);
+			addPlane(quadrics[from], plane[0], plane[1], plane[2], d, weight);
+			addPlane(quadrics[to], plane[0], plane[1], plane[2], d, weight);
+		}
+	}
+	std::sort(boundaryEdges.begin(), boundaryEdges.end());
+
+	std::vector<unsigned int> remap(numVertices);
+	std::vector<bool> locked(numVertices);
+	std::vector<unsigned int> liveTriangles(numVertices);
+	std::vector<unsigned int> offsets(numVertices + 1);
+	std::vector<unsigned int> adjacency;
+	std::vector<unsigned long long> edges;
+	std::vector<Collapse> collapses;
+	double largestError = 0;
+
+	// Each pass collapses the cheapest edges that do not touch each other, then rebuilds the triangle list
+	while (current.size() > targetCount) {
+		const unsigned int numTriangles = (unsigned int)current.size() / 3;
+
+		// The triangles touching each vertex, as one array with an offset per vertex
+		std::fill(liveTriangles.begin(), liveTriangles.end(), 0);
+		for (size_t i = 0; i < current.size(); ++i) {
+			++liveTriangles[current[i]];
+		}
+		offsets[0] = 0;
+		for (unsigned int v = 0; v < numVertices; ++v) {
+			offsets[v + 1] = offsets[v] + liveTriangles[v];
+		}
+		adjacency.resize(current.size());
+		std::vector<unsigned int> filled(offsets.begin(), offsets.end() - 1);
+		for (unsigned int t = 0; t < numTriangles; ++t) {
+			for (int corner = 0; corner < 3; ++corner) {
+				adjacency[filled[current[t * 3 + corner]]++] = t;
+			}
+		}
+
+		edges.clear();
+		for (size_t t = 0; t < current.size(); t += 3) {
+			for (int corner = 0; corner < 3; ++corner) {
+				const unsigned int a = current[t + corner], b = current[t + (corner + 1) % 3];
+				edges.push_back(edgeKey(std::min(a, b), std::max(a, b)));
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+		edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+		// Price both directions of every edge and keep the cheaper one that is allowed
+		collapses.clear();
+		for (size_t e = 0; e < edges.size(); ++e) {
+			const unsigned int ends[2] = { (unsigned int)(edges[e] >> 32), (unsigned int)edges[e] };
+			const bool alongBoundary = std::binary_search(boundaryEdges.begin(), boundaryEdges.end(), edges[e]);
+			Collapse best = { -1, 0, 0, 0 };
+			for (int direction = 0; direction < 2; ++direction) {
+				const unsigned int from = ends[direction], to = ends[1 - direction];
+				// A vertex on the outline may only slide along it, onto its neighbour on the outline
+				if (onBoundary[from] && !(alongBoundary && onBoundary[to])) {
+					continue;
+				}
+				Quadric combined = quadrics[from];
+				addQuadric(combined, quadrics[to]);
+				const double geometric = evaluate(combined, vertices + to * 3);
+				double cost = geometric;
+				if (attributes != nullptr) {
+					// The surviving vertex's attributes replace the removed one's
+					double difference = 0;
+					for (unsigned int k = 0; k < attributeComponents; ++k) {
+						const double delta = attributes[from * attributeComponents + k] - attributes[to * attributeComponents + k];
+						difference += delta * delta;
+					}
+					cost += attributeWeight * difference;
+				}
+				if (best.cost < 0 || cost < best.cost) {
+					best.cost = cost;
+					best.error = geometric;
+					best.from = from;
+					best.to = to;
+				}
+			}
+			if (best.cost >= 0) {
+				collapses.push_back(best);
+			}
+		}
+		std::sort(collapses.begin(), collapses.end());
+
+		for (unsigned int v = 0; v < numVertices; ++v) {
+			remap[v] = v;
+		}
+		std::fill(locked.begin(), locked.end(), false);
+		// Collapsing an inner edge removes the two triangles on it
+		const unsigned int trianglesToRemove = numTriangles - targetCount / 3;
+		unsigned int removed = 0;
+		for (size_t c = 0; c < collapses.size() && removed < trianglesToRemove; ++c) {
+			const Collapse& collapse = collapses[c];
+			if (locked[collapse.from] || locked[collapse.to]) {
+				continue;
+			}
+
+			// Refuse to turn any remaining triangle around
+			bool flips = false;
+			unsigned int collapsing = 0;
+			for (unsigned int a = offsets[collapse.from]; a < offsets[collapse.from + 1] && !flips; ++a) {
+				const unsigned int* corners = &current[adjacency[a] * 3];
+				if (corners[0] == collapse.to || corners[1] == collapse.to || corners[2] == collapse.to) {
+					++collapsing;
+					continue;
+				}
+				const float* before[3];
+				const float* after[3];
+				for (int corner = 0; corner < 3; ++corner) {
+					before[corner] = vertices + corners[corner] * 3;
+					after[corner] = corners[corner] == collapse.from ? vertices + collapse.to * 3 : before[corner];
+				}
+				double normalBefore[3], normalAfter[3];
+				cross(before[0], before[1], before[2], normalBefore);
+				cross(after[0], after[1], after[2], normalAfter);
+				flips = normalBefore[0] * normalAfter[0] + normalBefore[1] * normalAfter[1] + normalBefore[2] * normalAfter[2] <= 0;
+			}
+			if (flips) {
+				continue;
+			}
+
+			remap[collapse.from] = collapse.to;
+			addQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+			largestError = std::max(largestError, collapse.error);
+			removed += collapsing;
+			// Everything the collapse touched waits for the next pass, so collapses within a pass never interact
+			locked[collapse.to] = true;
+			for (unsigned int a = offsets[collapse.from]; a < offsets[collapse.from + 1]; ++a) {
+				const unsigned int* corners = &current[adjacency[a] * 3];
+				locked[corners[0]] = locked[corners[1]] = locked[corners[2]] = true;
+			}
+		}
+		if (removed == 0) {
+			break;
+		}
+
+		size_t kept = 0;
+		for (size_t t = 0; t < current.size(); t += 3) {
+			const unsigned int a = remap[current[t]], b = remap[current[t + 1]], c = remap[current[t + 2]];
+			if (a != b && b != c && c != a) {
+				current[kept++] = a;
+				current[kept++] = b;
+				current[kept++] = c;
+			}
+		}
+		current.resize(kept);
+	}
+
+	error = (float)sqrt(largestError);
+	std::copy(current.begin(), current.end(), destination);
+	return (unsigned int)current.size();
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+// Quadric error metric simplification (Garland and Heckbert) for indexed triangle lists.
+// Only half-edge collapses are used, so every vertex of the result is one of the input vertices:
+// simplified index buffers share the original vertex buffer, positions and attributes included.
+
+/// <summary> Simplifies a triangle list until it has at most <paramref name="targetCount"/> indices, or nothing more can be removed.
+/// Open edges are kept in place, and collapses that would flip a triangle are refused. </summary>
+/// <param name="destination"> Receives the simplified triangle list. Must hold <paramref name="count"/> values. </param>
+/// <param name="indices"> The triangle list to simplify. </param>
+/// <param name="count"> The number of indices. </param>
+/// <param name="vertices"> The vertex positions, 3 floats per vertex. </param>
+/// <param name="numVertices"> The number of vertices. </param>
+/// <param name="targetCount"> The number of indices to aim for. </param>
+/// <param name="error"> Receives an estimate of the farthest the result strays from the input, in model units. </param>
+/// <param name="attributes"> Optional per-vertex data, such as colors, whose differences add to the cost of a collapse. </param>
+/// <param name="attributeComponents"> The number of floats per vertex in <paramref name="attributes"/>. </param>
+/// <param name="attributeWeight"> How much an attribute difference costs relative to a squared distance. </param>
+/// <returns> The number of indices written to <paramref name="destination"/>. </returns>
+unsigned int simplifyMesh(unsigned int* destination, const unsigned int* indices, const unsigned int& count, const float* vertices, const unsigned int& numVertices,
+	const unsigned int& targetCount, float& error, const float* attributes = nullptr, const unsigned int& attributeComponents = 0, const float& attributeWeight = 1);
@@ -0,0 +1,252 @@
+#include "OcclusionCuller.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+OcclusionCuller::OcclusionCuller(const int& width, const int& height, const int& maxOccluders) {
+	// Powers of two make every pyramid texel cover exactly a 2x2 block of the level below
+	this->width = 4;
+	while (this->width < width) {
+		this->width *= 2;
+	}
+	this->height = 1;
+	while (this->height < height) {
+		this->height *= 2;
+	}
+	this->maxOccluders = maxOccluders;
+	occluderCount = 0;
+
+	int levelWidth = this->width, levelHeight = this->height;
+	pyramid.push_back(std::vector<float>(levelWidth * levelHeight, FLT_MAX));
+	while (levelWidth > 1 || levelHeight > 1) {
+		levelWidth = levelWidth > 1 ? levelWidth / 2 : 1;
+		levelHeight = levelHeight > 1 ? levelHeight / 2 : 1;
+		pyramid.push_back(std::vector<float>(levelWidth * levelHeight, FLT_MAX));
+	}
+}
+
+void OcclusionCuller::begin(const Matrix& projection, const Matrix& view) {
+	const Matrix viewProjection = projection * view;
+	for (int i = 0; i < 4; ++i) {
+		clipX[i] = viewProjection.getValue(0, i);
+		clipY[i] = viewProjection.getValue(1, i);
+		clipW[i] = viewProjection.getValue(3, i);
+		// The camera looks down -z, so depth is the negated third row of the view
+		depthRow[i] = -view.getValue(2, i);
+	}
+	for (int i = 0; i < 3; ++i) {
+		right[i] = view.getValue(0, i);
+		up[i] = view.getValue(1, i);
+	}
+	occluders.clear();
+	std::fill(pyramid[0].begin(), pyramid[0].end(), FLT_MAX);
+}
+
+bool OcclusionCuller::project(const float* point, float& px, float& py) const {
+	const float w = clipW[0] * point[0] + clipW[1] * point[1] + clipW[2] * point[2] + clipW[3];
+	if (w <= 1e-6f) {
+		return false;
+	}
+	const float x = clipX[0] * point[0] + clipX[1] * point[1] + clipX[2] * point[2] + clipX[3];
+	const float y = clipY[0] * point[0] + clipY[1] * point[1] + clipY[2] * point[2] + clipY[3];
+	px = (x / w * 0.5f + 0.5f) * width;
+	py = (y / w * 0.5f + 0.5f) * height;
+	return true;
+}
+
+void OcclusionCuller::addOccluder(const float& x, const float& y, const float& z, const float& radius) {
+	const float depth = depthRow[0] * x + depthRow[1] * y + depthRow[2] * z + depthRow[3];
+	if (radius <= 0 || depth <= radius) {
+		return;
+	}
+
+	// The largest square facing the camera that fits in the sphere's cross-section through its center.
+	// Every ray through the square enters the sphere before reaching it, so using the center's depth is conservative.
+	const float half = radius * 0.70710678f;
+	float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+	for (int corner = 0; corner < 4; ++corner) {
+		const float u = corner & 1 ? half : -half;
+		const float v = corner & 2 ? half : -half;
+		const float point[3] = {
+			x + right[0] * u + up[0] * v,
+			y + right[1] * u + up[1] * v,
+			z + right[2] * u + up[2] * v
+		};
+		float px, py;
+		if (!project(point, px, py)) {
+			return;
+		}
+		minX = fminf(minX, px);
+		minY = fminf(minY, py);
+		maxX = fmaxf(maxX, px);
+		maxY = fmaxf(maxY, py);
+	}
+
+	// Only pixels whose centers are covered
+	Occluder occluder;
+	occluder.x0 = std::max((int)ceilf(minX - 0.5f), 0);
+	occluder.y0 = std::max((int)ceilf(minY - 0.5f), 0);
+	occluder.x1 = std::min((int)floorf(maxX - 0.5f), width - 1);
+	occluder.y1 = std::min((int)floorf(maxY - 0.5f), height - 1);
+	if (occluder.x0 > occluder.x1 || occluder.y0 > occluder.y1) {
+		return;
+	}
+	occluder.depth = depth;
+	occluder.area = (occluder.x1 - occluder.x0 + 1) * (occluder.y1 - occluder.y0 + 1);
+	occluders.push_back(occluder);
+}
+
+void OcclusionCuller::fillRect(const Occluder& occluder) {
+	float* depth = pyramid[0].data();
+	for (int y = occluder.y0; y <= occluder.y1; ++y) {
+		float* row = depth + y * width;
+		int x = occluder.x0;
+#ifdef MATH_POLICY_SSE
+		const __m128 value = _mm_set1_ps(occluder.depth);
+		for (; x + 4 <= occluder.x1 + 1; x += 4) {
+			_mm_storeu_ps(row + x, _mm_min_ps(_mm_loadu_ps(row + x), value));
+		}
+#endif
+		for (; x <= occluder.x1; ++x) {
+			row[x] = fminf(row[x], occluder.depth);
+		}
+	}
+}
+
+void OcclusionCuller::downsample(const int& level) {
+	const float* source = pyramid[level - 1].data();
+	float* target = pyramid[level].data();
+	const int sourceWidth = getWidth(level - 1), sourceHeight = getHeight(level - 1);
+	const int targetWidth = getWidth(level), targetHeight = getHeight(level);
+
+#ifdef MATH_POLICY_SSE
+	if (sourceWidth >= 8 && sourceHeight >= 2) {
+		for (int y = 0; y < targetHeight; ++y) {
+			const float* a = source + y * 2 * sourceWidth;
+			const float* b = a + sourceWidth;
+			for (int x = 0; x < targetWidth; x += 4) {
+				const __m128 low = _mm_max_ps(_mm_loadu_ps(a + x * 2), _mm_loadu_ps(b + x * 2));
+				const __m128 high = _mm_max_ps(_mm_loadu_ps(a + x * 2 + 4), _mm_loadu_ps(b + x * 2 + 4));
+				const __m128 even = _mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0));
+				const __m128 odd = _mm_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1));
+				_mm_storeu_ps(target + y * targetWidth + x, _mm_max_ps(even, odd));
+			}
+		}
+		return;
+	}
+#endif
+	// Once a side is down to one texel it stays there, and both children along it are that texel
+	for (int y = 0; y < targetHeight; ++y) {
+		const int y0 = std::min(y * 2, sourceHeight - 1), y1 = std::min(y * 2 + 1, sourceHeight - 1);
+		for (int x = 0; x < targetWidth; ++x) {
+			const int x0 = std::min(x * 2, sourceWidth - 1), x1 = std::min(x * 2 + 1, sourceWidth - 1);
+			target[y * targetWidth + x] = fmaxf(
+				fmaxf(source[y0 * sourceWidth + x0], source[y0 * sourceWidth + x1]),
+				fmaxf(source[y1 * sourceWidth + x0], source[y1 * sourceWidth + x1])
+			);
+		}
+	}
+}
+
+void OcclusionCuller::rasterize() {
+	// Big occluders hide the most, so spend the budget on them
+	if ((int)occluders.size() > maxOccluders) {
+		std::nth_element(occluders.begin(), occluders.begin() + maxOccluders, occluders.end(),
+			[](const Occluder& a, const Occluder& b) { return a.area > b.area; });
+		occluders.resize(maxOccluders);
+	}
+	occluderCount = (int)occluders.size();
+	for (size_t i = 0; i < occluders.size(); ++i) {
+		fillRect(occluders[i]);
+	}
+	for (int level = 1; level < getLevels(); ++level) {
+		downsample(level);
+	}
+}
+
+bool OcclusionCuller::isVisible(const float& x, const float& y, const float& z, const float& radius) const {
+	if (occluderCount == 0) {
+		return true;
+	}
+	const float nearest = depthRow[0] * x + depthRow[1] * y + depthRow[2] * z + depthRow[3] - radius;
+	if (nearest <= 0) {
+		return true;
+	}
+
+	// Screen bounds of a camera-aligned box around the sphere
+	float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+	const float forward[3] = { depthRow[0], depthRow[1], depthRow[2] };
+	for (int corner = 0; corner < 8; ++corner) {
+		const float u = corner & 1 ? radius : -radius;
+		const float v = corner & 2 ? radius : -radius;
+		const float w = corner & 4 ? radius : -radius;
+		const float point[3] = {
+			x + right[0] * u + up[0] * v + forward[0] * w,
+			y + right[1] * u + up[1] * v + forward[1] * w,
+			z + right[2] * u + up[2] * v + forward[2] * w
+		};
+		float px, py;
+		if (!project(point, px, py)) {
+			return true;
+		}
+		minX = fminf(minX, px);
+		minY = fminf(minY, py);
+		maxX = fmaxf(maxX, px);
+		maxY = fmaxf(maxY, py);
+	}
+	if (maxX < 0 || maxY < 0 || minX >= width || minY >= height) {
+		return false;
+	}
+	const int x0 = std::max((int)floorf(minX), 0);
+	const int y0 = std::max((int)floorf(minY), 0);
+	const int x1 = std::min((int)floorf(maxX), width - 1);
+	const int y1 = std::min((int)floorf(maxY), height - 1);
+
+	// The coarsest level at which the bounds span at most three texels each way
+	const int span = std::max(x1 - x0, y1 - y0);
+	int level = 0;
+	while ((span >> level) > 1 && level + 1 < getLevels()) {
+		++level;
+	}
+	const float* depth = pyramid[level].data();
+	const int levelWidth = getWidth(level);
+	for (int ty = y0 >> level; ty <= y1 >> level; ++ty) {
+		for (int tx = x0 >> level; tx <= x1 >> level; ++tx) {
+			if (nearest < depth[ty * levelWidth + tx]) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+int OcclusionCuller::cullSpheres(const float* x, const float* y, const float* z, const float* radius, const int* candidates, const int& count, int* visible) const {
+	int visibleCount = 0;
+	for (int i = 0; i < count; ++i) {
+		const int index = candidates[i];
+		if (isVisible(x[index], y[index], z[index], radius[index])) {
+			visible[visibleCount++] = index;
+		}
+	}
+	return visibleCount;
+}
+
+int OcclusionCuller::getOccluderCount() const {
+	return occluderCount;
+}
+
+int OcclusionCuller::getLevels() const {
+	return (int)pyramid.size();
+}
+
+const float* OcclusionCuller::getDepth(const int& level) const {
+	return pyramid[level].data();
+}
+
+int OcclusionCuller::getWidth(const int& level) const {
+	return std::max(width >> level, 1);
+}
+
+int OcclusionCuller::getHeight(const int& level) const {
+	return std::max(height >> level, 1);
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <vector>
+#include "Matrix.h"
+
+/// <summary>
+/// Hides objects that are behind other, larger objects, without asking the GPU.
+/// Each frame the largest occluders are drawn into a small depth buffer as screen-aligned squares that fit inside them,
+/// a max-depth pyramid is built from it, and every other object's screen bounds are compared against the pyramid level
+/// where they cover at most a few texels. Everything happens on the CPU, so there is no GL dependency.
+///
+/// Depth is the distance in front of the camera, so the projection may be perspective or orthographic.
+/// Per frame: begin(), addOccluder() for each candidate, rasterize(), then isVisible() or cullSpheres().
+/// </summary>
+class OcclusionCuller {
+public:
+	/// <summary> OcclusionCuller constructor. </summary>
+	/// <param name="width"> The width of the depth buffer, rounded up to a power of two. </param>
+	/// <param name="height"> The height of the depth buffer, rounded up to a power of two. </param>
+	/// <param name="maxOccluders"> The most occluders to draw each frame. The ones covering the most screen are kept. </param>
+	OcclusionCuller(const int& width = 256, const int& height = 128, const int& maxOccluders = 32);
+
+	/// <summary> Starts a frame: clears the depth buffer and forgets last frame's occluders. </summary>
+	/// <param name="projection"> The projection matrix. </param>
+	/// <param name="view"> The view matrix. </param>
+	void begin(const Matrix& projection, const Matrix& view);
+
+	/// <summary> Offers a solid sphere as an occluder. </summary>
+	/// <param name="x"> The x-coord of the sphere's center. </param>
+	/// <param name="y"> The y-coord of the sphere's center. </param>
+	/// <param name="z"> The z-coord of the sphere's center. </param>
+	/// <param name="radius"> The radius of a sphere that is entirely inside the object. </param>
+	void addOccluder(const float& x, const float& y, const float& z, const float& radius);
+
+	/// <summary> Draws the largest occluders into the depth buffer and builds the depth pyramid. </summary>
+	void rasterize();
+
+	/// <summary> Checks whether any part of a sphere could be in front of the occluders. </summary>
+	/// <param name="x"> The x-coord of the sphere's center. </param>
+	/// <param name="y"> The y-coord of the sphere's center. </param>
+	/// <param name="z"> The z-coord of the sphere's center. </param>
+	/// <param name="radius"> The radius of the sphere. </param>
+	bool isVisible(const float& x, const float& y, const float& z, const float& radius) const;
+
+	/// <summary> Filters a list of sphere indices, keeping the ones that may be visible. </summary>
+	/// <param name="x"> The x-coords of the sphere centers. </param>
+	/// <param name="y"> The y-coords of the sphere centers. </param>
+	/// <param name="z"> The z-coords of the sphere centers. </param>
+	/// <param name="radius"> The radii of the spheres. </param>
+	/// <param name="candidates"> The indices of the spheres to test. </param>
+	/// <param name="count"> The number of candidates. </param>
+	/// <param name="visible"> Receives the indices of the visible candidates, in order. May be the same array as <paramref name="candidates"/>. </param>
+	/// <returns> The number of visible spheres. </returns>
+	int cullSpheres(const float* x, const float* y, const float* z, const float* radius, const int* candidates, const int& count, int* visible) const;
+
+	/// <summary> Returns the number of occluders drawn by the last rasterize(). </summary>
+	int getOccluderCount() const;
+	/// <summary> Returns the number of pyramid levels. Level 0 is the full depth buffer. </summary>
+	int getLevels() const;
+	/// <summary> Returns a pyramid level, stored by row. Each texel is the farthest depth of the pixels it covers. </summary>
+	/// <param name="level"> The level to get. </param>
+	const float* getDepth(const int& level) const;
+	/// <summary> Returns the width of a pyramid level. </summary>
+	int getWidth(const int& level = 0) const;
+	/// <summary> Returns the height of a pyramid level. </summary>
+	int getHeight(const int& level = 0) const;
+
+private:
+	struct Occluder {
+		/// <summary> The occluder's bounds in level 0 pixels, inclusive. </summary>
+		int x0, y0, x1, y1;
+		float depth;
+		int area;
+	};
+
+	int width, height, maxOccluders;
+	/// <summary> The rows of projection * view that give clip x, y and w, and the view row that gives depth. </summary>
+	float clipX[4], clipY[4], clipW[4], depthRow[4];
+	/// <summary> Camera space right and up, in world space, so occluder squares can face the camera. </summary>
+	float right[3], up[3];
+	std::vector<Occluder> occluders;
+	std::vector<std::vector<float>> pyramid;
+	int occluderCount;
+
+	/// <summary> Projects a world point to level 0 pixel coordinates. Returns false if it is not in front of the camera. </summary>
+	bool project(const float* point, float& px, float& py) const;
+	/// <summary> Writes the nearer of <paramref name="depth"/> and the existing depth over a rectangle of level 0. </summary>
+	void fillRect(const Occluder& occluder);
+	/// <summary> Builds level <paramref name="level"/> of the pyramid from the level below it. </summary>
+	void downsample(const int& level);
+};
@@ -1,4 +1,5 @@
 #include "Particle.h"
+#include "Profiler.h"
 
 Particle::Particle() {
 	force = Vector();
@@ -11,14 +12,15 @@ Particle::Particle() {
 }
 
 void Particle::updatePhysics(const float& dtime) {
+	PROFILE_ZONE("Integrate");
 	velocity += force / mass * dtime;
 	graphics->setLocation(graphics->getLocation() + velocity * dtime);
 	avelocity += torque / momi * dtime;
 	graphics->setRotation(graphics->getRotation() + avelocity * dtime);
 }
 
-void Particle::draw(const Matrix& projection, const Matrix& view) {
-	graphics->render(projection, view);
+void Particle::submit(RenderQueue& queue) {
+	graphics->submit(queue);
 }
 
 void Particle::translate(const Vector& translation) {
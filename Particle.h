@@ -21,10 +21,9 @@ public:
 	/// <summary> Called once per frame on this object to update its physics. </summary>
 	/// <param name="dtime"> The amount of time since the last frame, in seconds. </param>
 	void updatePhysics(const float& dtime);
-	/// <summary> Called once per frame on this object to update its graphics. </summary>
-	/// <param name="projection"> The projection matrix. </param>
-	/// <param name="view"> The view matrix. </param>
-	void draw(const Matrix& projection, const Matrix& view);
+	/// <summary> Queues this object's draws on <paramref name="queue"/>. </summary>
+	/// <param name="queue"> The queue to draw this object with. </param>
+	void submit(RenderQueue& queue);
 	/// <summary> Translate this shape. </summary>
 	/// <param name="translation"> The amount to translate by. </param>
 	void translate(const Vector& translation);
@@ -0,0 +1,72 @@
+#include "PointCloud.h"
+
+PointCloud::PointCloud(const float& pointSize) : stream(GL_ARRAY_BUFFER) {
+	this->pointSize = pointSize;
+	programLoaded = false;
+	pointScaleUniform = -1;
+	vertexArray = 0;
+	count = 0;
+	positionOffset = 0;
+	colorOffset = 0;
+	viewportHeight = 0;
+}
+
+void PointCloud::setViewportHeight(const int& height) {
+	viewportHeight = height;
+}
+
+void PointCloud::begin(const unsigned int& count, float*& positions, unsigned char*& colors) {
+	// Positions and colors are each one block, so a writer fills two plain arrays
+	const size_t positionBytes = sizeof(float) * 3 * count;
+	const size_t colorBytes = 4 * (size_t)count;
+	stream.reserve(positionBytes + colorBytes + 32);
+	stream.beginFrame();
+	positions = (float*)stream.allocate(positionBytes, positionOffset);
+	colors = (unsigned char*)stream.allocate(colorBytes, colorOffset);
+	this->count = count;
+}
+
+void PointCloud::draw(const Matrix& projection) {
+	stream.commit();
+	if (count == 0) {
+		return;
+	}
+	if (!programLoaded) {
+		program = loadShaderProgram("pointVertex.txt", "pointFragment.txt");
+		pointScaleUniform = glGetUniformLocation(program.id, "pointScale");
+		glGenVertexArrays(1, &vertexArray);
+		glBindVertexArray(vertexArray);
+		glEnableVertexAttribArray(program.shapeLocationAttribute);
+		glEnableVertexAttribArray(program.shapeColorAttribute);
+		glBindVertexArray(0);
+		programLoaded = true;
+	}
+	if (viewportHeight == 0) {
+		int viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		viewportHeight = viewport[3];
+	}
+
+	glUseProgram(program.id);
+	// One world unit at clip w covers projection[1][1] * height / 2 / w pixels, the same measure RenderQueue uses for
+	// level of detail. The shader divides by w, which is 1 for an orthographic projection.
+	glUniform1f(pointScaleUniform, pointSize * fabsf(projection.getValue(1, 1)) * viewportHeight * 0.5f);
+	glEnable(GL_PROGRAM_POINT_SIZE);
+	glBindVertexArray(vertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, stream.getBuffer());
+	glVertexAttribPointer(program.shapeLocationAttribute, 3, GL_FLOAT, false, 0, (void*)positionOffset);
+	glVertexAttribPointer(program.shapeColorAttribute, 4, GL_UNSIGNED_BYTE, true, 0, (void*)colorOffset);
+	glDrawArrays(GL_POINTS, 0, count);
+	glBindVertexArray(0);
+	glDisable(GL_PROGRAM_POINT_SIZE);
+	glUseProgram(0);
+	count = 0;
+}
+
+void PointCloud::release() {
+	stream.destroy();
+	if (vertexArray != 0) {
+		glDeleteVertexArrays(1, &vertexArray);
+		vertexArray = 0;
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "DynamicBuffer.h"
+#include "Matrix.h"
+#include "WebGLUtility.h"
+
+/// <summary>
+/// Draws very large numbers of tiny bodies, such as the particles of a gas, as round GL_POINTS. Nothing is kept per point:
+/// each frame the positions and colors are written straight into one streamed vertex buffer and drawn with a single call,
+/// so there are no shapes, no culling and no instance data. Points shrink with distance like a sphere of pointSize would.
+///
+/// Per frame, on the GL thread: begin() with the number of points, write them, then draw() with the Frame uniform block
+/// bound, see FrameUniforms. Writing may happen from any thread in between, for example straight from a simulation step.
+/// </summary>
+class PointCloud {
+public:
+	/// <summary> The diameter of every point, in world units. Can be modified directly. </summary>
+	float pointSize;
+
+	/// <summary> PointCloud constructor. No GL objects are created until the first begin(). </summary>
+	/// <param name="pointSize"> The diameter of every point, in world units. </param>
+	PointCloud(const float& pointSize = 0.05f);
+
+	/// <summary> Sets the height of the viewport being drawn to, which point sizes are worked out from.
+	/// Until this is called, the GL viewport is read on the first draw(). </summary>
+	/// <param name="height"> The height of the viewport, in pixels. </param>
+	void setViewportHeight(const int& height);
+
+	/// <summary> Starts a frame of <paramref name="count"/> points and returns where to write them. The memory is the GL
+	/// buffer itself and should only be written, in order: reading it back is slow. </summary>
+	/// <param name="count"> The number of points to draw this frame. </param>
+	/// <param name="positions"> Receives where to write the positions, 3 floats per point. </param>
+	/// <param name="colors"> Receives where to write the RGBA colors, 4 bytes per point. </param>
+	void begin(const unsigned int& count, float*& positions, unsigned char*& colors);
+
+	/// <summary> Draws the points written since begin(). Loads the program the first time. </summary>
+	/// <param name="projection"> The projection matrix, which sets how quickly points shrink with distance. </param>
+	void draw(const Matrix& projection);
+
+	/// <summary> Deletes the vertex buffer and vertex array, for when the context is destroyed before this. GL thread only.
+	/// </summary>
+	void release();
+
+private:
+	ShaderProgram program;
+	bool programLoaded;
+	int pointScaleUniform;
+	unsigned int vertexArray;
+	DynamicBuffer stream;
+	unsigned int count;
+	size_t positionOffset, colorOffset;
+	int viewportHeight;
+};
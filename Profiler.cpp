@@ -0,0 +1,240 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+using std::cout; using std::endl;
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+bool Profiler::enabled = false;
+
+namespace {
+	struct ZoneRecord {
+		const char* name;
+		long long start;
+		long long end;
+	};
+
+	/// <summary> The zones of one thread, or of one lane from addLane(). The newest is at (count - 1) % bufferZones. </summary>
+	struct ZoneBuffer {
+		/// <summary> The row of the trace this buffer's zones are drawn in. </summary>
+		int lane;
+		/// <summary> The name of the row, or nullptr for a thread's. </summary>
+		const char* name;
+		std::vector<ZoneRecord> zones;
+		/// <summary> How many zones were ever recorded, including those overwritten since. </summary>
+		unsigned long long count;
+	};
+
+	std::mutex buffersMutex;
+	/// <summary> Every buffer, by lane. Never freed, so zones outlive the threads that recorded them. </summary>
+	std::vector<ZoneBuffer*> buffers;
+	/// <summary> Buffers whose threads have exited, for the next new thread. </summary>
+	std::vector<ZoneBuffer*> freeBuffers;
+
+	/// <summary> Holds the calling thread's buffer, and gives it back when the thread exits. </summary>
+	struct BufferLease {
+		ZoneBuffer* buffer = nullptr;
+
+		~BufferLease() {
+			if (buffer != nullptr) {
+				std::lock_guard<std::mutex> lock(buffersMutex);
+				freeBuffers.push_back(buffer);
+			}
+		}
+	};
+
+	thread_local BufferLease lease;
+
+	/// <summary> Adds a buffer. Call with buffersMutex locked. </summary>
+	ZoneBuffer* createBuffer(const char* name) {
+		ZoneBuffer* buffer = new ZoneBuffer();
+		buffer->lane = (int)buffers.size();
+		buffer->name = name;
+		buffer->zones.resize(Profiler::bufferZones);
+		buffer->count = 0;
+		buffers.push_back(buffer);
+		return buffer;
+	}
+
+	ZoneBuffer* acquireBuffer() {
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		if (!freeBuffers.empty()) {
+			ZoneBuffer* buffer = freeBuffers.back();
+			freeBuffers.pop_back();
+			return buffer;
+		}
+		return createBuffer(nullptr);
+	}
+
+	void writeZone(ZoneBuffer& buffer, const char* name, const long long& start, const long long& end) {
+		ZoneRecord& zone = buffer.zones[buffer.count % Profiler::bufferZones];
+		zone.name = name;
+		zone.start = start;
+		zone.end = end;
+		++buffer.count;
+	}
+
+	// When the program started by both clocks, to measure the time stamp counter against and to start the trace at
+	const long long startTicks = Profiler::now();
+	const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	double microsecondsPerTick = 0;
+
+	/// <summary> Measures the time stamp counter against steady_clock, over at least 10 ms so the rate is good to a few
+	/// parts per million. </summary>
+	void calibrate() {
+		double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+		if (elapsed < 10000) {
+			std::this_thread::sleep_for(std::chrono::microseconds((long long)(10000 - elapsed)));
+		}
+		const long long endTicks = Profiler::now();
+		elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+		microsecondsPerTick = elapsed / (double)(endTicks - startTicks);
+	}
+
+	/// <summary> Copies every kept zone, with the lane it was recorded on. Call while no other thread is recording. </summary>
+	void collectZones(std::vector<std::pair<int, ZoneRecord>>& out) {
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		for (size_t i = 0; i < buffers.size(); ++i) {
+			const ZoneBuffer& buffer = *buffers[i];
+			const unsigned long long kept = std::min(buffer.count, (unsigned long long)Profiler::bufferZones);
+			for (unsigned long long j = buffer.count - kept; j < buffer.count; ++j) {
+				out.push_back(std::make_pair(buffer.lane, buffer.zones[j % Profiler::bufferZones]));
+			}
+		}
+	}
+
+	/// <summary> Writes a zone name as a JSON string. </summary>
+	void writeName(std::ofstream& file, const char* name) {
+		file << '"';
+		for (const char* c = name; *c != '\0'; ++c) {
+			if (*c == '"' || *c == '\\') {
+				file << '\\';
+			}
+			file << *c;
+		}
+		file << '"';
+	}
+}
+
+double Profiler::toMicroseconds(const long long& ticks) {
+#ifdef PROFILER_RDTSC
+	if (microsecondsPerTick == 0) {
+		calibrate();
+	}
+	return ticks * microsecondsPerTick;
+#else
+	return ticks / 1000.0;
+#endif
+}
+
+long long Profiler::toTicks(const double& microseconds) {
+#ifdef PROFILER_RDTSC
+	if (microsecondsPerTick == 0) {
+		calibrate();
+	}
+	return (long long)(microseconds / microsecondsPerTick);
+#else
+	return (long long)(microseconds * 1000);
+#endif
+}
+
+void Profiler::record(const char* name, const long long& start, const long long& end) {
+	ZoneBuffer* buffer = lease.buffer;
+	if (buffer == nullptr) {
+		buffer = lease.buffer = acquireBuffer();
+	}
+	writeZone(*buffer, name, start, end);
+}
+
+int Profiler::addLane(const char* name) {
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	return createBuffer(name)->lane;
+}
+
+void Profiler::record(const int& lane, const char* name, const long long& start, const long long& end) {
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	writeZone(*buffers[lane], name, start, end);
+}
+
+bool Profiler::writeTrace(const string& path) {
+	std::vector<std::pair<int, ZoneRecord>> zones;
+	collectZones(zones);
+	std::ofstream file(path);
+	if (!file.is_open()) {
+		cout << "Unable to write trace " << path << endl;
+		return false;
+	}
+	file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+	char line[128];
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		for (size_t i = 0; i < buffers.size(); ++i) {
+			snprintf(line, sizeof(line), "Thread %d", buffers[i]->lane);
+			file << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << buffers[i]->lane << ", \"args\": {\"name\": ";
+			writeName(file, buffers[i]->name != nullptr ? buffers[i]->name : line);
+			file << "}},\n";
+		}
+	}
+	for (size_t i = 0; i < zones.size(); ++i) {
+		const ZoneRecord& zone = zones[i].second;
+		// Complete events, in microseconds since the program started
+		file << "{\"name\": ";
+		writeName(file, zone.name);
+		snprintf(line, sizeof(line), ", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}%s\n", zones[i].first,
+			toMicroseconds(zone.start - startTicks), toMicroseconds(zone.end - zone.start), i + 1 < zones.size() ? "," : "");
+		file << line;
+	}
+	file << "]}\n";
+	return file.good();
+}
+
+void Profiler::printSummary() {
+	std::vector<std::pair<int, ZoneRecord>> zones;
+	collectZones(zones);
+	// By name rather than pointer, since each file may have its own copy of a literal
+	std::map<string, std::vector<double>> durations;
+	for (size_t i = 0; i < zones.size(); ++i) {
+		const ZoneRecord& zone = zones[i].second;
+		durations[zone.name].push_back(toMicroseconds(zone.end - zone.start) / 1000);
+	}
+	std::vector<std::pair<double, string>> order;
+	for (std::map<string, std::vector<double>>::iterator it = durations.begin(); it != durations.end(); ++it) {
+		std::sort(it->second.begin(), it->second.end());
+		double total = 0;
+		for (size_t i = 0; i < it->second.size(); ++i) {
+			total += it->second[i];
+		}
+		order.push_back(std::make_pair(-total, it->first));
+	}
+	std::sort(order.begin(), order.end());
+
+	char line[160];
+	snprintf(line, sizeof(line), "%-24s %8s %10s %10s %10s %10s %10s %10s", "Zone", "Count", "Total ms", "Mean", "P50", "P90", "P99", "Max");
+	cout << line << endl;
+	for (size_t i = 0; i < order.size(); ++i) {
+		const std::vector<double>& sorted = durations[order[i].second];
+		const size_t count = sorted.size();
+		// Nearest rank: the smallest duration at least the given fraction of zones are no longer than
+		double percentiles[3];
+		const double fractions[3] = { 0.5, 0.9, 0.99 };
+		for (int p = 0; p < 3; ++p) {
+			const size_t rank = (size_t)ceil(fractions[p] * count);
+			percentiles[p] = sorted[rank > 0 ? rank - 1 : 0];
+		}
+		snprintf(line, sizeof(line), "%-24s %8d %10.3f %10.4f %10.4f %10.4f %10.4f %10.4f", order[i].second.c_str(), (int)count,
+			-order[i].first, -order[i].first / count, percentiles[0], percentiles[1], percentiles[2], sorted[count - 1]);
+		cout << line << endl;
+	}
+}
+
+void Profiler::clear() {
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	for (size_t i = 0; i < buffers.size(); ++i) {
+		buffers[i]->count = 0;
+	}
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <chrono>
+#include <string>
+using std::string;
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define PROFILER_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILER_RDTSC
+#endif
+
+/// <summary>
+/// Times named zones of code on every thread, cheaply enough to leave in the frame loop, to show where a frame's time goes.
+///
+/// Each thread records into a ring buffer of its own, so recording takes no lock and never allocates; once a buffer is
+/// full its oldest zones are overwritten. Times are read from the time stamp counter where there is one, which costs a
+/// few nanoseconds, and from steady_clock elsewhere. Threads that exit hand their buffer to the next thread that starts,
+/// so short-lived workers share lanes in the trace instead of adding one each.
+///
+/// Mark a zone with PROFILE_ZONE("Name") at the top of a scope, or with PROFILE_ZONE_BEGIN and PROFILE_ZONE_END around
+/// part of one; names must be string literals. writeTrace() saves every
+/// kept zone in the Chrome trace format, for chrome://tracing or ui.perfetto.dev, and printSummary() prints percentiles
+/// of each zone's duration. Both read every thread's buffer, so call them while no other thread is recording.
+/// Define PROFILER_OFF to compile every zone out.
+/// </summary>
+class Profiler {
+public:
+	/// <summary> Whether zones are recorded. Off by default. Can be modified directly. </summary>
+	static bool enabled;
+
+	/// <summary> The most zones kept per thread. </summary>
+	static const int bufferZones = 1 << 16;
+
+	/// <summary> Returns the current time in ticks, which toMicroseconds() converts. Defined here so zones can inline it. </summary>
+	static inline long long now() {
+#ifdef PROFILER_RDTSC
+		return (long long)__rdtsc();
+#else
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+
+	/// <summary> Converts a span of ticks to microseconds. The time stamp counter is measured against steady_clock the
+	/// first time this is called, which waits until at least 10 ms have passed since the program started. </summary>
+	static double toMicroseconds(const long long& ticks);
+	/// <summary> Converts a span of microseconds to ticks, the inverse of toMicroseconds(). </summary>
+	static long long toTicks(const double& microseconds);
+
+	/// <summary> Records a zone on the calling thread, timed by the caller. </summary>
+	/// <param name="name"> The name of the zone. Must outlive the profiler. </param>
+	/// <param name="start"> When the zone started, in ticks. </param>
+	/// <param name="end"> When the zone ended, in ticks. </param>
+	static void record(const char* name, const long long& start, const long long& end);
+
+	/// <summary> Adds a row to the trace for zones that are not timed by a thread, such as those a GpuTimer reads back. </summary>
+	/// <param name="name"> The name of the row. Must outlive the profiler. </param>
+	/// <returns> The lane, for record(). </returns>
+	static int addLane(const char* name);
+
+	/// <summary> Records a zone on a lane from addLane(). Takes a lock, so it is meant for a few zones per frame. </summary>
+	/// <param name="lane"> The lane to record on. </param>
+	/// <param name="name"> The name of the zone. Must outlive the profiler. </param>
+	/// <param name="start"> When the zone started, in ticks. </param>
+	/// <param name="end"> When the zone ended, in ticks. </param>
+	static void record(const int& lane, const char* name, const long long& start, const long long& end);
+
+	/// <summary> Writes every kept zone as a Chrome trace, one row per thread. </summary>
+	/// <param name="path"> The JSON file to write. </param>
+	/// <returns> Whether the file could be written. </returns>
+	static bool writeTrace(const string& path);
+
+	/// <summary> Prints, for each zone name, how often it ran and the mean, 50th, 90th and 99th percentile and longest
+	/// durations in milliseconds, the zones that took the most time in total first. </summary>
+	static void printSummary();
+
+	/// <summary> Forgets every recorded zone. </summary>
+	static void clear();
+};
+
+/// <summary> Records a zone from its construction to the end of its scope, if the Profiler is enabled. See PROFILE_ZONE. </summary>
+class ProfileZone {
+public:
+	ProfileZone(const char* name) : name(Profiler::enabled ? name : nullptr), start(this->name != nullptr ? Profiler::now() : 0) {}
+
+	~ProfileZone() {
+		end();
+	}
+
+	/// <summary> Ends the zone before the end of its scope, for timing part of a long function. </summary>
+	void end() {
+		if (name != nullptr) {
+			Profiler::record(name, start, Profiler::now());
+			name = nullptr;
+		}
+	}
+
+private:
+	const char* name;
+	long long start;
+
+	ProfileZone(const ProfileZone&);
+	ProfileZone& operator=(const ProfileZone&);
+};
+
+#ifdef PROFILER_OFF
+#define PROFILE_ZONE(name)
+#define PROFILE_ZONE_BEGIN(zone, name)
+#define PROFILE_ZONE_END(zone)
+#else
+#define PROFILE_ZONE_VARIABLE(name, line) ProfileZone profileZone##line(name)
+#define PROFILE_ZONE_LINE(name, line) PROFILE_ZONE_VARIABLE(name, line)
+/// <summary> Times the rest of the enclosing scope as a zone called <paramref name="name"/>. </summary>
+#define PROFILE_ZONE(name) PROFILE_ZONE_LINE(name, __LINE__)
+/// <summary> Starts a zone called <paramref name="name"/>, held in a variable called <paramref name="zone"/>, that lasts
+/// until PROFILE_ZONE_END(zone) or the end of the enclosing scope, whichever comes first. </summary>
+#define PROFILE_ZONE_BEGIN(zone, name) ProfileZone zone(name)
+/// <summary> Ends a zone started by PROFILE_ZONE_BEGIN. </summary>
+#define PROFILE_ZONE_END(zone) zone.end()
+#endif
@@ -0,0 +1,310 @@
+#include "RenderQueue.h"
+#include "GraphicsShape.h"
+#include "Profiler.h"
+#include <cfloat>
+#include <chrono>
+#include <cstring>
+
+RenderQueue::RenderQueue() : instanceStream(GL_ARRAY_BUFFER) {
+	occlusionCulling = true;
+	lodErrorPixels = 1;
+	lodHysteresis = 0.25f;
+	impostorPixels = 16;
+	software = nullptr;
+	gpuTiming = false;
+	viewportWidth = 0;
+	viewportHeight = 0;
+}
+
+void RenderQueue::setViewport(const int& width, const int& height) {
+	viewportWidth = width;
+	viewportHeight = height;
+}
+
+void RenderQueue::preload() {
+	GraphicsShape::preload();
+	impostors.preload();
+}
+
+void RenderQueue::add(GraphicsShape* shape) {
+	shapes.push_back(shape);
+}
+
+void RenderQueue::addItem(const ShaderProgram* program, const MeshHandle& mesh, const Pass& pass, const char& lod, const float* instance) {
+	DrawItem item;
+	item.key = (unsigned long long)(program->id & 0xFFFF) << 32
+		| (unsigned long long)(mesh.index & 0xFFFFFF) << 8
+		| (unsigned long long)pass << 6
+		| (unsigned long long)(lod & 0x3F);
+	item.program = program;
+	item.mesh = mesh;
+	item.instance = (unsigned int)(instances.size() / GraphicsShape::instanceFloats);
+	items.push_back(item);
+	instances.insert(instances.end(), instance, instance + GraphicsShape::instanceFloats);
+}
+
+void RenderQueue::sortItems() {
+	sortScratch.resize(items.size());
+	for (int shift = 0; shift < 64; shift += 8) {
+		size_t counts[256] = { 0 };
+		for (size_t i = 0; i < items.size(); ++i) {
+			++counts[(items[i].key >> shift) & 0xFF];
+		}
+		// Every key has the same byte here, so this pass would not move anything
+		if (counts[(items[0].key >> shift) & 0xFF] == items.size()) {
+			continue;
+		}
+		size_t offsets[256];
+		size_t total = 0;
+		for (int i = 0; i < 256; ++i) {
+			offsets[i] = total;
+			total += counts[i];
+		}
+		for (size_t i = 0; i < items.size(); ++i) {
+			sortScratch[offsets[(items[i].key >> shift) & 0xFF]++] = items[i];
+		}
+		items.swap(sortScratch);
+	}
+}
+
+void RenderQueue::flush(const Matrix& projection, const Matrix& view) {
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	const bool timed = gpuTiming && software == nullptr;
+	if (timed) {
+		gpuTimer.beginFrame();
+	}
+	cullAndDraw(projection, view);
+	if (timed) {
+		gpuTimer.endFrame();
+		stats.gpuMilliseconds = gpuTimer.getFrameMilliseconds();
+	}
+	stats.cpuMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void RenderQueue::cullAndDraw(const Matrix& projection, const Matrix& view) {
+	stats = Stats();
+	stats.shapes = (int)shapes.size();
+	PROFILE_ZONE_BEGIN(culling, "Culling");
+
+	// Gather every bounding sphere, then cull them all in one batch
+	const size_t count = shapes.size();
+	boundsX.resize(count);
+	boundsY.resize(count);
+	boundsZ.resize(count);
+	boundsRadius.resize(count);
+	visible.resize(count);
+	for (size_t i = 0; i < count; ++i) {
+		boundsX[i] = shapes[i]->x;
+		boundsY[i] = shapes[i]->y;
+		boundsZ[i] = shapes[i]->z;
+		boundsRadius[i] = shapes[i]->getBoundingRadius();
+	}
+	const Matrix viewProjection = projection * view;
+	const Frustum frustum(viewProjection);
+	int visibleCount = frustum.cullSpheres(boundsX.data(), boundsY.data(), boundsZ.data(), boundsRadius.data(), (int)count, visible.data());
+	stats.frustumCulled = (int)count - visibleCount;
+
+	// Draw the solid shapes that survived into a small depth buffer, then drop whatever is behind them
+	if (occlusionCulling && visibleCount > 1) {
+		occlusion.begin(projection, view);
+		for (int i = 0; i < visibleCount; ++i) {
+			const int index = visible[i];
+			const float radius = shapes[index]->getOccluderRadius();
+			if (radius > 0) {
+				occlusion.addOccluder(boundsX[index], boundsY[index], boundsZ[index], radius);
+			}
+		}
+		occlusion.rasterize();
+		stats.occluders = occlusion.getOccluderCount();
+		const int unoccluded = occlusion.cullSpheres(boundsX.data(), boundsY.data(), boundsZ.data(), boundsRadius.data(), visible.data(), visibleCount, visible.data());
+		stats.occlusionCulled = visibleCount - unoccluded;
+		visibleCount = unoccluded;
+	}
+
+	PROFILE_ZONE_END(culling);
+	PROFILE_ZONE("Render submit");
+
+	// Level of detail for every survivor in one pass. One world unit at clip w covers
+	// projection[1][1] * height / 2 / w pixels; w is the distance for a perspective projection and 1 for an orthographic one.
+	if (software != nullptr) {
+		setViewport(software->getWidth(), software->getHeight());
+	}
+	else if (viewportHeight == 0) {
+		int viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		setViewport(viewport[2], viewport[3]);
+	}
+	const float pixelsPerClipUnit = fabsf(projection.getValue(1, 1)) * viewportHeight * 0.5f;
+	pixelsPerUnit.resize(visibleCount);
+	for (int i = 0; i < visibleCount; ++i) {
+		const int index = visible[i];
+		const float w = viewProjection.getValue(3, 0) * boundsX[index] + viewProjection.getValue(3, 1) * boundsY[index]
+			+ viewProjection.getValue(3, 2) * boundsZ[index] + viewProjection.getValue(3, 3);
+		// Shapes reaching the camera plane get the finest level rather than a division by zero
+		pixelsPerUnit[i] = w > 1e-4f ? pixelsPerClipUnit / w : FLT_MAX;
+	}
+	for (int i = 0; i < visibleCount; ++i) {
+		shapes[visible[i]]->selectLOD(pixelsPerUnit[i], lodErrorPixels, lodHysteresis);
+	}
+
+	// Only the survivors pay for a model matrix
+	const bool impostorsReady = impostors.isReady();
+	for (int i = 0; i < visibleCount; ++i) {
+		const int index = visible[i];
+		GraphicsShape* shape = shapes[index];
+		const MeshRegistry::Mesh& mesh = MeshRegistry::get(shape->mesh);
+		if (software != nullptr) {
+			if (!shape->wire) {
+				float instance[GraphicsShape::instanceFloats];
+				shape->writeInstance(instance);
+				software->draw(mesh, shape->currentLOD, instance, viewProjection);
+				++stats.draws;
+			}
+			continue;
+		}
+		// Small spheres are cheaper as impostors, as long as they are scaled evenly and not in wireframe.
+		// Their vertex colors are lost, but are too small to make out by then. Until the impostor program is built they
+		// stay meshes, which are ready to draw.
+		if (mesh.sphere && !shape->wire && impostorsReady && pixelsPerUnit[i] * boundsRadius[index] < impostorPixels
+			&& fabsf(shape->sx) == fabsf(shape->sy) && fabsf(shape->sy) == fabsf(shape->sz)) {
+			impostors.add(boundsX[index], boundsY[index], boundsZ[index], boundsRadius[index], shape->color);
+			continue;
+		}
+		float instance[GraphicsShape::instanceFloats];
+		shape->writeInstance(instance);
+		const bool edges = mesh.numEdgeVertices > 0;
+		if (GraphicsShape::edgeMode == GraphicsShape::BARYCENTRIC) {
+			// One pass either way. Faces only pay for the geometry shader when there are edges to draw on them.
+			if (shape->wire) {
+				addItem(&GraphicsShape::wireProgram, shape->mesh, WIRE, shape->currentLOD, instance);
+			}
+			else {
+				addItem(edges ? &GraphicsShape::wireProgram : &GraphicsShape::program, shape->mesh, FACES, shape->currentLOD, instance);
+			}
+		}
+		else {
+			if (!shape->wire) {
+				addItem(&GraphicsShape::program, shape->mesh, FACES, shape->currentLOD, instance);
+			}
+			// Meshes without edges would draw nothing
+			if (edges) {
+				addItem(&GraphicsShape::program, shape->mesh, EDGES, 0, instance);
+			}
+		}
+	}
+	shapes.clear();
+
+	if (software != nullptr) {
+		software->rasterize();
+		return;
+	}
+
+	// Drawn first, since impostors write their own depth and cannot be rejected early by what is in front of them anyway
+	stats.impostors = impostors.getCount();
+	gpuTimer.begin("GPU impostors");
+	impostors.draw();
+	gpuTimer.end();
+
+	stats.items = (int)items.size();
+	if (items.empty()) {
+		return;
+	}
+
+	sortItems();
+
+	// Lay the instance data out in draw order, so each run of identical state reads one contiguous range.
+	// It is written straight into GL memory.
+	const size_t instanceBytes = sizeof(float) * GraphicsShape::instanceFloats;
+	instanceStream.reserve(instanceBytes * items.size());
+	instanceStream.beginFrame();
+	size_t baseOffset = 0;
+	float* upload = (float*)instanceStream.allocate(instanceBytes * items.size(), baseOffset);
+	for (size_t i = 0; i < items.size(); ++i) {
+		memcpy(upload + i * GraphicsShape::instanceFloats, &instances[items[i].instance * GraphicsShape::instanceFloats], instanceBytes);
+	}
+	instanceStream.commit();
+	glBindBuffer(GL_ARRAY_BUFFER, instanceStream.getBuffer());
+
+	const ShaderProgram* boundProgram = nullptr;
+	unsigned int boundVertexArray = 0;
+	unsigned int boundTexture = 0;
+
+	// Each batch is timed on the GPU as its pass, when timing
+	const char* const passZones[3] = { "GPU faces", "GPU edges", "GPU wire" };
+	size_t first = 0;
+	while (first < items.size()) {
+		const DrawItem& item = items[first];
+		size_t last = first + 1;
+		// Meshes past the 24 bits of the key could share one, so compare the handles too
+		while (last < items.size() && items[last].key == item.key && items[last].mesh == item.mesh) {
+			++last;
+		}
+		const int count = (int)(last - first);
+		const Pass pass = (Pass)((item.key >> 6) & 0x3);
+		const int lod = (int)(item.key & 0x3F);
+		const MeshRegistry::Mesh& mesh = MeshRegistry::get(item.mesh);
+		gpuTimer.begin(passZones[pass]);
+
+		if (item.program != boundProgram) {
+			glUseProgram(item.program->id);
+			boundProgram = item.program;
+			++stats.programBinds;
+		}
+
+		// Both VAOs already point at the mesh's one index buffer
+		const unsigned int vertexArray = pass == EDGES ? mesh.edgesVAO : mesh.facesVAO;
+		if (vertexArray != boundVertexArray) {
+			glBindVertexArray(vertexArray);
+			boundVertexArray = vertexArray;
+			++stats.vertexArrayBinds;
+		}
+
+		GraphicsShape::bindInstances(*item.program, baseOffset + instanceBytes * first);
+
+		if (item.program == &GraphicsShape::wireProgram) {
+			// Without masks, every side of every triangle is drawn
+			const bool masked = mesh.numEdgeVertices > 0;
+			if (masked && mesh.edgeMaskTexture != boundTexture) {
+				glActiveTexture(GL_TEXTURE0 + edgeMaskTextureUnit);
+				glBindTexture(GL_TEXTURE_BUFFER, mesh.edgeMaskTexture);
+				boundTexture = mesh.edgeMaskTexture;
+				++stats.textureBinds;
+			}
+			glUniform1i(item.program->edgeMaskedUniform, masked);
+			glUniform1i(item.program->firstTriangleUniform, (int)(mesh.firstIndex[lod] / 3));
+			glUniform1i(item.program->wireUniform, pass == WIRE);
+		}
+
+		if (pass != EDGES) {
+			glDrawElementsInstanced(GL_TRIANGLES, mesh.numTriangleVertices[lod], mesh.indexType,
+				(void*)((size_t)mesh.firstIndex[lod] * mesh.indexSize), count);
+		}
+		else {
+			glDrawElementsInstanced(GL_LINES, mesh.numEdgeVertices, mesh.indexType,
+				(void*)((size_t)mesh.firstEdgeIndex * mesh.indexSize), count);
+		}
+		++stats.draws;
+		gpuTimer.end();
+
+		first = last;
+	}
+
+	glBindVertexArray(0);
+	glUseProgram(0);
+	if (boundTexture != 0) {
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+	}
+
+	items.clear();
+	instances.clear();
+}
+
+const RenderQueue::Stats& RenderQueue::getStats() const {
+	return stats;
+}
+
+void RenderQueue::release() {
+	instanceStream.destroy();
+	impostors.release();
+	gpuTimer.release();
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include <vector>
+#include "DynamicBuffer.h"
+#include "Frustum.h"
+#include "GpuTimer.h"
+#include "MeshRegistry.h"
+#include "OcclusionCuller.h"
+#include "SoftwareRasterizer.h"
+#include "SphereImpostors.h"
+#include "WebGLUtility.h"
+
+class GraphicsShape;
+
+/// <summary>
+/// Collects a frame's shapes, culls the ones that cannot be seen, sorts the rest by render state and submits them with
+/// as few state changes as possible. Draws that end up next to each other with identical state are merged into a
+/// single instanced draw, so the number of GL calls grows with the number of distinct states rather than the number of objects.
+/// </summary>
+class RenderQueue {
+public:
+	/// <summary> Which part of a shape a draw item renders. Faces sort before edges. </summary>
+	enum Pass {
+		/// <summary> The faces, and with the barycentric program their edges too. </summary>
+		FACES = 0,
+		/// <summary> The edge list, as lines. </summary>
+		EDGES = 1,
+		/// <summary> The edges alone, drawn from the faces by the barycentric program. </summary>
+		WIRE = 2
+	};
+
+	/// <summary> Counts and timings from the most recent flush(). </summary>
+	struct Stats {
+		int shapes = 0;
+		int frustumCulled = 0;
+		int occluders = 0;
+		int occlusionCulled = 0;
+		int items = 0;
+		int draws = 0;
+		int programBinds = 0;
+		int vertexArrayBinds = 0;
+		int textureBinds = 0;
+		int impostors = 0;
+		/// <summary> How long flush() took on the CPU, in milliseconds. </summary>
+		float cpuMilliseconds = 0;
+		/// <summary> How long the GPU took to draw a recent flush, in milliseconds: the latest whose timings have arrived,
+		/// usually one or two frames back. -1 without gpuTiming, or until the first arrives. </summary>
+		float gpuMilliseconds = -1;
+	};
+
+	RenderQueue();
+
+	/// <summary> Whether to hide shapes that are behind large solid shapes. Can be modified directly. </summary>
+	bool occlusionCulling;
+	/// <summary> The largest error, in pixels, a level of detail may show on screen. Can be modified directly. </summary>
+	float lodErrorPixels;
+	/// <summary> How far below lodErrorPixels, as a fraction of it, an error must fall before a shape switches to a coarser level.
+	/// Can be modified directly. </summary>
+	float lodHysteresis;
+	/// <summary> Spheres whose radius on screen is under this many pixels are drawn as ray-cast impostors instead of meshes,
+	/// see SphereImpostors. 0 never uses impostors. Can be modified directly. </summary>
+	float impostorPixels;
+	/// <summary> When set, flush() draws into this on the CPU instead of through GL, and shapes are submitted without
+	/// being uploaded, so no GL context is needed at all. Its size is the viewport. Can be modified directly. </summary>
+	SoftwareRasterizer* software;
+	/// <summary> Whether to time each flush on the GPU, along with the impostors and each batch of draws, see GpuTimer.
+	/// The frame time goes in Stats, and every zone into the Profiler when it is enabled. Can be modified directly. </summary>
+	bool gpuTiming;
+
+	/// <summary> Sets the size of the viewport being drawn to, used to measure level of detail errors in pixels.
+	/// Until this is called, the GL viewport is read on the first flush(). </summary>
+	/// <param name="width"> The width of the viewport, in pixels. </param>
+	/// <param name="height"> The height of the viewport, in pixels. </param>
+	void setViewport(const int& width, const int& height);
+
+	/// <summary> Starts building every program this queue and GraphicsShape draw with, so the first frame that needs one
+	/// does not wait for the compiler. See GraphicsShape::preload(). </summary>
+	void preload();
+
+	/// <summary> Queues a shape. It must already be buffered, see GraphicsShape::submit(). </summary>
+	/// <param name="shape"> The shape to draw. Must stay alive until the next flush(). </param>
+	void add(GraphicsShape* shape);
+
+	/// <summary> Culls, sorts and draws every queued shape, then empties the queue.
+	/// The matrices are used for culling and level of detail; the shaders read theirs from the Frame uniform block, see FrameUniforms. </summary>
+	/// <param name="projection"> The projection matrix. </param>
+	/// <param name="view"> The view matrix. </param>
+	void flush(const Matrix& projection, const Matrix& view);
+
+	/// <summary> Returns the GL call counts and timings from the most recent flush(). </summary>
+	const Stats& getStats() const;
+
+	/// <summary> Deletes the buffers the queue streams through and the GPU timer's queries, while the context is still
+	/// current. Call it before destroying the context when the queue outlives it; the next flush() creates them again. </summary>
+	void release();
+
+private:
+	/// <summary> One queued draw. Sorting only moves these, never the instance data they point at. </summary>
+	struct DrawItem {
+		/// <summary> program (16 bits) | mesh (24 bits) | pass (2 bits) | lod (6 bits), most significant first. </summary>
+		unsigned long long key;
+		const ShaderProgram* program;
+		MeshHandle mesh;
+		unsigned int instance;
+	};
+
+	std::vector<GraphicsShape*> shapes;
+	/// <summary> Bounding spheres of the queued shapes, one array per component so they can be tested four at a time. </summary>
+	std::vector<float> boundsX, boundsY, boundsZ, boundsRadius;
+	std::vector<int> visible;
+	std::vector<float> pixelsPerUnit;
+	int viewportWidth, viewportHeight;
+	OcclusionCuller occlusion;
+	SphereImpostors impostors;
+	std::vector<DrawItem> items, sortScratch;
+	std::vector<float> instances;
+	/// <summary> Per-instance data in draw order, streamed to the GPU each flush. </summary>
+	DynamicBuffer instanceStream;
+	Stats stats;
+	GpuTimer gpuTimer;
+
+	/// <summary> Everything flush() does apart from timing it. </summary>
+	void cullAndDraw(const Matrix& projection, const Matrix& view);
+
+	/// <summary> Queues one pass of a visible shape. </summary>
+	void addItem(const ShaderProgram* program, const MeshHandle& mesh, const Pass& pass, const char& lod, const float* instance);
+	/// <summary> Stable LSD radix sort of items by key, one byte per pass. Bytes shared by every key are skipped. </summary>
+	void sortItems();
+
+	// The streamed buffers belong to one queue
+	RenderQueue(const RenderQueue&);
+	RenderQueue& operator=(const RenderQueue&);
+};
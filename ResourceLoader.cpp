@@ -0,0 +1,127 @@
+#include "ResourceLoader.h"
+#include "GraphicsShape.h"
+#include "Profiler.h"
+
+namespace {
+	/// <summary> Copies what GraphicsShape::uploadBuffers() made from the loader's copy of a record to the registry's,
+	/// leaving every other field as the drawing thread has it now. </summary>
+	void copyUpload(const MeshRegistry::Mesh& from, MeshRegistry::Mesh& to) {
+		if (to.packedVertices == nullptr) {
+			to.radius = from.radius;
+		}
+		to.layout = from.layout;
+		to.vertexBuffer = from.vertexBuffer;
+		to.edgeColorsBuffer = from.edgeColorsBuffer;
+		to.indexBuffer = from.indexBuffer;
+		to.indexType = from.indexType;
+		to.indexSize = from.indexSize;
+		to.firstIndex = from.firstIndex;
+		to.firstEdgeIndex = from.firstEdgeIndex;
+		to.numEdgeVertices = from.numEdgeVertices;
+		to.edgeMaskBuffer = from.edgeMaskBuffer;
+		to.edgeMaskTexture = from.edgeMaskTexture;
+	}
+}
+
+ResourceLoader::ResourceLoader(const std::function<void(const bool&)>& bindContext) {
+	stopping = false;
+	pending = 0;
+	// Started last, so the thread never sees a member before it is set
+	thread = std::thread(&ResourceLoader::run, this, bindContext);
+}
+
+ResourceLoader::~ResourceLoader() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_one();
+	thread.join();
+	// Uploads that were never handed back. Their buffers are left to the context, like every other mesh's.
+	for (size_t i = 0; i < uploaded.size(); ++i) {
+		glDeleteSync(uploaded[i].fence);
+	}
+	for (size_t i = 0; i < fenced.size(); ++i) {
+		glDeleteSync(fenced[i].fence);
+	}
+}
+
+void ResourceLoader::load(const MeshHandle& mesh) {
+	MeshRegistry::Mesh& data = MeshRegistry::get(mesh);
+	if (data.buffered || data.loading || data.vertexBuffer != 0) {
+		return;
+	}
+	data.loading = true;
+	Job job;
+	job.handle = mesh;
+	job.mesh = data;
+	// Chosen now, so changing the layout later only affects meshes loaded later
+	if (job.mesh.packedVertices == nullptr) {
+		job.mesh.layout = GraphicsShape::vertexLayout;
+	}
+	job.fence = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queued.push_back(job);
+	}
+	wake.notify_one();
+	++pending;
+}
+
+int ResourceLoader::poll() {
+	if (pending == 0) {
+		return 0;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		fenced.insert(fenced.end(), uploaded.begin(), uploaded.end());
+		uploaded.clear();
+	}
+	int done = 0;
+	for (size_t i = 0; i < fenced.size();) {
+		// A zero timeout only asks, so a mesh the GPU is still copying waits for the next frame
+		const GLenum status = glClientWaitSync(fenced[i].fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+			++i;
+			continue;
+		}
+		glDeleteSync(fenced[i].fence);
+		MeshRegistry::Mesh& data = MeshRegistry::get(fenced[i].handle);
+		copyUpload(fenced[i].mesh, data);
+		data.loading = false;
+		fenced.erase(fenced.begin() + i);
+		++done;
+	}
+	pending -= done;
+	return done;
+}
+
+int ResourceLoader::getPending() const {
+	return pending;
+}
+
+void ResourceLoader::run(std::function<void(const bool&)> bindContext) {
+	bindContext(true);
+	while (true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this] { return stopping || !queued.empty(); });
+			if (stopping) {
+				break;
+			}
+			job = queued.front();
+			queued.pop_front();
+		}
+		{
+			PROFILE_ZONE("Upload mesh");
+			GraphicsShape::uploadBuffers(job.mesh);
+			job.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			// The fence must reach the GPU before another context can see it signal
+			glFlush();
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		uploaded.push_back(job);
+	}
+	bindContext(false);
+}
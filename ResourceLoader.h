@@ -0,0 +1,72 @@
+#pragma once
+#include <GLAD/glad.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "MeshRegistry.h"
+
+/// <summary>
+/// Uploads meshes from a thread of its own, through a second GL context that shares objects with the drawing one, so a
+/// new mesh never stalls a frame while its vertices are packed and copied to the GPU.
+///
+/// load() copies the mesh record and marks it loading. The loader thread fills the buffers and edge mask texture of the
+/// copy, then puts a fence after them. poll(), called once per frame on the drawing thread, copies the GL objects and
+/// index ranges of each mesh whose fence has signaled back into the MeshRegistry. VAOs are not shared between contexts,
+/// so GraphicsShape makes those itself the next time the mesh is drawn.
+///
+/// Usually driven through GraphicsShape::loader, which loads each mesh the first time a shape drawing it is submitted.
+/// </summary>
+class ResourceLoader {
+public:
+	/// <summary> ResourceLoader constructor. Starts the loader thread. </summary>
+	/// <param name="bindContext"> Called on the loader thread with true before anything is uploaded, to make current a
+	/// context that shares objects with the drawing context, and with false before the thread exits, to release it. </param>
+	ResourceLoader(const std::function<void(const bool&)>& bindContext);
+	/// <summary> Stops the loader thread once the mesh it is uploading is done. Meshes still queued are never loaded.
+	/// Call on the drawing thread while its context is current, since the fences of meshes not handed back are deleted. </summary>
+	~ResourceLoader();
+
+	/// <summary> Queues a mesh to be uploaded, unless it is uploaded or queued already. Its source data must not be
+	/// modified until it is done. Meshes not packed already are stored in GraphicsShape::vertexLayout as it is now. </summary>
+	/// <param name="mesh"> The mesh to upload. </param>
+	void load(const MeshHandle& mesh);
+
+	/// <summary> Hands every mesh whose upload the GPU has finished back to the MeshRegistry. Never waits.
+	/// Call once per frame on the drawing thread. </summary>
+	/// <returns> The number of meshes that were handed back. </returns>
+	int poll();
+
+	/// <summary> Returns the number of meshes queued or uploading that poll() has not handed back yet. </summary>
+	int getPending() const;
+
+private:
+	/// <summary> A mesh being uploaded. The record is a copy, so the registry can grow while the loader fills it. </summary>
+	struct Job {
+		MeshHandle handle;
+		MeshRegistry::Mesh mesh;
+		GLsync fence;
+	};
+
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool stopping;
+	/// <summary> Jobs for the loader thread, oldest first. </summary>
+	std::deque<Job> queued;
+	/// <summary> Jobs the loader thread has fenced, for poll() to hand back. </summary>
+	std::vector<Job> uploaded;
+	/// <summary> Jobs taken from uploaded whose fences had not signaled yet. Only touched by poll(). </summary>
+	std::vector<Job> fenced;
+	/// <summary> The number of jobs between load() and poll(). Only touched on the drawing thread. </summary>
+	int pending;
+
+	/// <summary> The loader thread: uploads queued jobs until the loader is destroyed. </summary>
+	void run(std::function<void(const bool&)> bindContext);
+
+	// The thread belongs to one object
+	ResourceLoader(const ResourceLoader&);
+	ResourceLoader& operator=(const ResourceLoader&);
+};
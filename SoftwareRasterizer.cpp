@@ -0,0 +1,412 @@
+#include "SoftwareRasterizer.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+using std::cout; using std::endl;
+#include <limits>
+#include <thread>
+#ifdef MATH_POLICY_SSE
+#include <emmintrin.h>
+#endif
+
+namespace {
+	/// <summary> Packs an RGBA color in [0, 1] into the bytes R, G, B, A, as a unorm8 framebuffer stores it. </summary>
+	unsigned int packColor(const float* rgba) {
+		unsigned int packed = 0;
+		for (int i = 0; i < 4; ++i) {
+			const float clamped = rgba[i] < 0 ? 0 : rgba[i] > 1 ? 1 : rgba[i];
+			packed |= (unsigned int)(clamped * 255 + 0.5f) << (i * 8);
+		}
+		return packed;
+	}
+}
+
+SoftwareRasterizer::SoftwareRasterizer(const int& width, const int& height, const int& threads) {
+	this->width = width;
+	this->height = height;
+	this->threads = threads > 0 ? threads : std::max(1, (int)std::thread::hardware_concurrency());
+	cullBackFaces = true;
+	tilesX = (width + tileSize - 1) / tileSize;
+	tilesY = (height + tileSize - 1) / tileSize;
+	color.resize((size_t)width * height);
+	depth.resize((size_t)width * height);
+	bins.resize((size_t)tilesX * tilesY);
+	drawCount = 0;
+	clear(0, 0, 0, 1);
+}
+
+void SoftwareRasterizer::clear(const float& r, const float& g, const float& b, const float& a) {
+	const float rgba[4] = { r, g, b, a };
+	std::fill(color.begin(), color.end(), packColor(rgba));
+	std::fill(depth.begin(), depth.end(), 1.0f);
+	triangles.clear();
+	for (size_t i = 0; i < bins.size(); ++i) {
+		bins[i].clear();
+	}
+}
+
+void SoftwareRasterizer::draw(const MeshRegistry::Mesh& mesh, const int& lod, const float* instance, const Matrix& viewProjection) {
+	// The model matrix arrives by column, like the GL instance attribute; viewProjection is stored by row
+	const float* vp = viewProjection.getValues();
+	float mvp[16];
+	for (int row = 0; row < 4; ++row) {
+		for (int col = 0; col < 4; ++col) {
+			mvp[row * 4 + col] = vp[row * 4] * instance[col * 4] + vp[row * 4 + 1] * instance[col * 4 + 1]
+				+ vp[row * 4 + 2] * instance[col * 4 + 2] + vp[row * 4 + 3] * instance[col * 4 + 3];
+		}
+	}
+	const float* tint = instance + 16;
+
+	// Read the vertices as they would be uploaded: quantized layouts are fractions of the radius, which the instance
+	// scales back. A mesh the GL path already packed keeps its float source, so undo that scale for it.
+	const unsigned int stride = MeshRegistry::getVertexStride(mesh.layout);
+	const float sourceScale = mesh.packedVertices == nullptr && mesh.layout != MeshRegistry::FULL_PRECISION && mesh.radius > 0
+		? 1 / mesh.radius : 1;
+
+	++drawCount;
+	if (transformed.size() < mesh.numVertices) {
+		transformed.resize(mesh.numVertices);
+		transformedDraw.resize(mesh.numVertices, 0);
+	}
+	auto fetch = [&](const unsigned int& i) -> const ClipVertex& {
+		ClipVertex& vertex = transformed[i];
+		if (transformedDraw[i] == drawCount) {
+			return vertex;
+		}
+		transformedDraw[i] = drawCount;
+		float position[3], rgba[4];
+		if (mesh.packedVertices == nullptr) {
+			for (int j = 0; j < 3; ++j) {
+				position[j] = mesh.vertices[i * 3 + j] * sourceScale;
+			}
+			for (int j = 0; j < 4; ++j) {
+				rgba[j] = mesh.colors[i * 4 + j];
+			}
+		}
+		else if (mesh.layout == MeshRegistry::FULL_PRECISION) {
+			const float* values = (const float*)(mesh.packedVertices + stride * i);
+			for (int j = 0; j < 3; ++j) {
+				position[j] = values[j];
+			}
+			for (int j = 0; j < 4; ++j) {
+				rgba[j] = values[3 + j];
+			}
+		}
+		else {
+			const unsigned char* packed = mesh.packedVertices + stride * i;
+			const short* quantized = (const short*)packed;
+			for (int j = 0; j < 3; ++j) {
+				position[j] = std::max(quantized[j] / 32767.0f, -1.0f);
+			}
+			const unsigned char* bytes = packed + (mesh.layout == MeshRegistry::QUANTIZED_NORMALS ? 12 : 8);
+			for (int j = 0; j < 4; ++j) {
+				rgba[j] = bytes[j] / 255.0f;
+			}
+		}
+		vertex.x = mvp[0] * position[0] + mvp[1] * position[1] + mvp[2] * position[2] + mvp[3];
+		vertex.y = mvp[4] * position[0] + mvp[5] * position[1] + mvp[6] * position[2] + mvp[7];
+		vertex.z = mvp[8] * position[0] + mvp[9] * position[1] + mvp[10] * position[2] + mvp[11];
+		vertex.w = mvp[12] * position[0] + mvp[13] * position[1] + mvp[14] * position[2] + mvp[15];
+		for (int j = 0; j < 4; ++j) {
+			vertex.color[j] = rgba[j] * tint[j];
+		}
+		return vertex;
+	};
+
+	const unsigned int count = mesh.numTriangleVertices[lod];
+	if (mesh.packedTriangles != nullptr) {
+		const unsigned char* indices = mesh.packedTriangles[lod];
+		if (MeshRegistry::getIndexSize(mesh.numVertices) == sizeof(unsigned short)) {
+			const unsigned short* narrow = (const unsigned short*)indices;
+			for (unsigned int i = 0; i + 2 < count; i += 3) {
+				addTriangle(fetch(narrow[i]), fetch(narrow[i + 1]), fetch(narrow[i + 2]));
+			}
+		}
+		else {
+			const unsigned int* wide = (const unsigned int*)indices;
+			for (unsigned int i = 0; i + 2 < count; i += 3) {
+				addTriangle(fetch(wide[i]), fetch(wide[i + 1]), fetch(wide[i + 2]));
+			}
+		}
+	}
+	else {
+		const unsigned int* indices = mesh.triangles[lod];
+		for (unsigned int i = 0; i + 2 < count; i += 3) {
+			addTriangle(fetch(indices[i]), fetch(indices[i + 1]), fetch(indices[i + 2]));
+		}
+	}
+}
+
+void SoftwareRasterizer::addTriangle(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c) {
+	// Entirely outside one side of the view volume
+	if ((a.x > a.w && b.x > b.w && c.x > c.w) || (a.x < -a.w && b.x < -b.w && c.x < -c.w)
+		|| (a.y > a.w && b.y > b.w && c.y > c.w) || (a.y < -a.w && b.y < -b.w && c.y < -c.w)
+		|| (a.z > a.w && b.z > b.w && c.z > c.w)) {
+		return;
+	}
+
+	// Only the near plane needs real clipping: it keeps w positive. The other sides are handled by the pixel bounds
+	// and the depth test against the cleared far plane.
+	const ClipVertex input[3] = { a, b, c };
+	const float distance[3] = { a.z + a.w, b.z + b.w, c.z + c.w };
+	if (distance[0] >= 0 && distance[1] >= 0 && distance[2] >= 0) {
+		setupTriangle(input);
+		return;
+	}
+	ClipVertex output[4];
+	int outputCount = 0;
+	for (int i = 0; i < 3; ++i) {
+		const int next = (i + 1) % 3;
+		if (distance[i] >= 0) {
+			output[outputCount++] = input[i];
+		}
+		if ((distance[i] >= 0) != (distance[next] >= 0)) {
+			const float t = distance[i] / (distance[i] - distance[next]);
+			ClipVertex& clipped = output[outputCount++];
+			clipped.x = input[i].x + (input[next].x - input[i].x) * t;
+			clipped.y = input[i].y + (input[next].y - input[i].y) * t;
+			clipped.z = input[i].z + (input[next].z - input[i].z) * t;
+			clipped.w = input[i].w + (input[next].w - input[i].w) * t;
+			for (int j = 0; j < 4; ++j) {
+				clipped.color[j] = input[i].color[j] + (input[next].color[j] - input[i].color[j]) * t;
+			}
+		}
+	}
+	// A fan of the clipped polygon, which keeps the winding
+	for (int i = 1; i + 1 < outputCount; ++i) {
+		const ClipVertex fan[3] = { output[0], output[i], output[i + 1] };
+		setupTriangle(fan);
+	}
+}
+
+void SoftwareRasterizer::setupTriangle(const ClipVertex* vertices) {
+	// To window coordinates, with y up like GL
+	float x[3], y[3], z[3], inverseW[3];
+	for (int i = 0; i < 3; ++i) {
+		inverseW[i] = 1 / vertices[i].w;
+		x[i] = (vertices[i].x * inverseW[i] * 0.5f + 0.5f) * width;
+		y[i] = (vertices[i].y * inverseW[i] * 0.5f + 0.5f) * height;
+		z[i] = vertices[i].z * inverseW[i] * 0.5f + 0.5f;
+	}
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (area == 0 || !std::isfinite(area)) {
+		return;
+	}
+	// Counter-clockwise faces the camera. Back faces that are kept are flipped so their edge functions are positive inside.
+	int order[3] = { 0, 1, 2 };
+	if (area < 0) {
+		if (cullBackFaces) {
+			return;
+		}
+		std::swap(order[1], order[2]);
+		area = -area;
+	}
+
+	Triangle triangle;
+	const float minX = std::min(x[0], std::min(x[1], x[2])), maxX = std::max(x[0], std::max(x[1], x[2]));
+	const float minY = std::min(y[0], std::min(y[1], y[2])), maxY = std::max(y[0], std::max(y[1], y[2]));
+	triangle.x0 = std::max(0, (int)floorf(minX));
+	triangle.y0 = std::max(0, (int)floorf(minY));
+	triangle.x1 = std::min(width - 1, (int)ceilf(std::min(maxX, (float)width)));
+	triangle.y1 = std::min(height - 1, (int)ceilf(std::min(maxY, (float)height)));
+	if (triangle.x0 > triangle.x1 || triangle.y0 > triangle.y1) {
+		return;
+	}
+
+	const float inverseArea = 1 / area;
+	for (int i = 0; i < 3; ++i) {
+		const int vertex = order[i];
+		// The edge across from this vertex, which is 0 along the edge and 1 at the vertex
+		const int from = order[(i + 1) % 3], to = order[(i + 2) % 3];
+		const float edgeA = y[from] - y[to];
+		const float edgeB = x[to] - x[from];
+		triangle.edgeA[i] = edgeA * inverseArea;
+		triangle.edgeB[i] = edgeB * inverseArea;
+		triangle.edgeC[i] = -(edgeA * x[from] + edgeB * y[from]) * inverseArea;
+		// With y up and counter-clockwise winding, left edges go down and top edges go left
+		const bool topLeft = edgeA > 0 || (edgeA == 0 && edgeB < 0);
+		triangle.threshold[i] = topLeft ? -std::numeric_limits<float>::denorm_min() : 0;
+		triangle.z[i] = z[vertex];
+		triangle.inverseW[i] = inverseW[vertex];
+		for (int j = 0; j < 4; ++j) {
+			triangle.color[i][j] = vertices[vertex].color[j] * inverseW[vertex];
+		}
+	}
+
+	const unsigned int index = (unsigned int)triangles.size();
+	triangles.push_back(triangle);
+	for (int ty = triangle.y0 / tileSize; ty <= triangle.y1 / tileSize; ++ty) {
+		for (int tx = triangle.x0 / tileSize; tx <= triangle.x1 / tileSize; ++tx) {
+			bins[ty * tilesX + tx].push_back(index);
+		}
+	}
+}
+
+void SoftwareRasterizer::rasterize() {
+	PROFILE_ZONE("Rasterize");
+	int busyTiles = 0;
+	for (size_t i = 0; i < bins.size(); ++i) {
+		busyTiles += !bins[i].empty();
+	}
+	// Tiles are handed out one at a time, so a thread stuck on a dense tile does not hold up the rest
+	std::atomic<int> nextTile(0);
+	const int tileCount = (int)bins.size();
+	auto work = [&]() {
+		PROFILE_ZONE("Rasterize tiles");
+		for (int tile = nextTile++; tile < tileCount; tile = nextTile++) {
+			if (!bins[tile].empty()) {
+				rasterizeTile(tile);
+			}
+		}
+	};
+	std::vector<std::thread> workers;
+	for (int i = 1; i < std::min(threads, busyTiles); ++i) {
+		workers.push_back(std::thread(work));
+	}
+	work();
+	for (size_t i = 0; i < workers.size(); ++i) {
+		workers[i].join();
+	}
+
+	triangles.clear();
+	for (size_t i = 0; i < bins.size(); ++i) {
+		bins[i].clear();
+	}
+}
+
+void SoftwareRasterizer::rasterizeTile(const int& tile) {
+	const int tileX0 = (tile % tilesX) * tileSize, tileY0 = (tile / tilesX) * tileSize;
+	const int tileX1 = std::min(tileX0 + tileSize, width) - 1, tileY1 = std::min(tileY0 + tileSize, height) - 1;
+	const std::vector<unsigned int>& bin = bins[tile];
+
+	for (size_t n = 0; n < bin.size(); ++n) {
+		const Triangle& t = triangles[bin[n]];
+		const int x0 = std::max(t.x0, tileX0), x1 = std::min(t.x1, tileX1);
+		const int y0 = std::max(t.y0, tileY0), y1 = std::min(t.y1, tileY1);
+		if (x0 > x1 || y0 > y1) {
+			continue;
+		}
+		for (int y = y0; y <= y1; ++y) {
+			const float centerY = y + 0.5f;
+			float* depthRow = &depth[(size_t)y * width];
+			unsigned int* colorRow = &color[(size_t)y * width];
+			int x = x0;
+#ifdef MATH_POLICY_SSE
+			// Four pixels at a time, starting on a multiple of four so a group never leaves the tile.
+			// The last group of a row that is not a multiple of four wide is left to the loop below.
+			x = x0 & ~3;
+			const __m128 steps = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+			const __m128i first = _mm_set1_epi32(x0), last = _mm_set1_epi32(x1);
+			const __m128i laneSteps = _mm_set_epi32(3, 2, 1, 0);
+			for (; x <= x1 && x + 4 <= width; x += 4) {
+				const __m128 centerX = _mm_add_ps(_mm_set1_ps((float)x), steps);
+				__m128 weight[3];
+				__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+				for (int i = 0; i < 3; ++i) {
+					weight[i] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.edgeA[i]), centerX), _mm_set1_ps(t.edgeB[i] * centerY + t.edgeC[i]));
+					inside = _mm_and_ps(inside, _mm_cmpgt_ps(weight[i], _mm_set1_ps(t.threshold[i])));
+				}
+				// Lanes outside this triangle's part of the tile
+				const __m128i lanes = _mm_add_epi32(_mm_set1_epi32(x), laneSteps);
+				const __m128i outside = _mm_or_si128(_mm_cmplt_epi32(lanes, first), _mm_cmpgt_epi32(lanes, last));
+				inside = _mm_andnot_ps(_mm_castsi128_ps(outside), inside);
+				if (_mm_movemask_ps(inside) == 0) {
+					continue;
+				}
+				const __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(weight[0], _mm_set1_ps(t.z[0])), _mm_mul_ps(weight[1], _mm_set1_ps(t.z[1]))),
+					_mm_mul_ps(weight[2], _mm_set1_ps(t.z[2])));
+				const __m128 oldDepth = _mm_loadu_ps(depthRow + x);
+				const __m128 pass = _mm_and_ps(inside, _mm_cmplt_ps(z, oldDepth));
+				if (_mm_movemask_ps(pass) == 0) {
+					continue;
+				}
+				_mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(pass, z), _mm_andnot_ps(pass, oldDepth)));
+
+				// Perspective correct color: interpolate color / w and 1 / w, then divide
+				const __m128 inverseW = _mm_add_ps(_mm_add_ps(_mm_mul_ps(weight[0], _mm_set1_ps(t.inverseW[0])),
+					_mm_mul_ps(weight[1], _mm_set1_ps(t.inverseW[1]))), _mm_mul_ps(weight[2], _mm_set1_ps(t.inverseW[2])));
+				const __m128 w = _mm_div_ps(_mm_set1_ps(1), inverseW);
+				__m128i packed = _mm_setzero_si128();
+				for (int j = 0; j < 4; ++j) {
+					__m128 channel = _mm_add_ps(_mm_add_ps(_mm_mul_ps(weight[0], _mm_set1_ps(t.color[0][j])),
+						_mm_mul_ps(weight[1], _mm_set1_ps(t.color[1][j]))), _mm_mul_ps(weight[2], _mm_set1_ps(t.color[2][j])));
+					channel = _mm_min_ps(_mm_max_ps(_mm_mul_ps(channel, w), _mm_setzero_ps()), _mm_set1_ps(1));
+					const __m128i value = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(channel, _mm_set1_ps(255)), _mm_set1_ps(0.5f)));
+					packed = _mm_or_si128(packed, _mm_slli_epi32(value, j * 8));
+				}
+				const __m128i passBits = _mm_castps_si128(pass);
+				const __m128i oldColor = _mm_loadu_si128((const __m128i*)(colorRow + x));
+				_mm_storeu_si128((__m128i*)(colorRow + x), _mm_or_si128(_mm_and_si128(passBits, packed), _mm_andnot_si128(passBits, oldColor)));
+			}
+			x = std::max(x, x0);
+#endif
+			for (; x <= x1; ++x) {
+				const float centerX = x + 0.5f;
+				float weight[3];
+				bool inside = true;
+				for (int i = 0; i < 3; ++i) {
+					weight[i] = t.edgeA[i] * centerX + t.edgeB[i] * centerY + t.edgeC[i];
+					inside = inside && weight[i] > t.threshold[i];
+				}
+				if (!inside) {
+					continue;
+				}
+				const float z = weight[0] * t.z[0] + weight[1] * t.z[1] + weight[2] * t.z[2];
+				if (!(z < depthRow[x])) {
+					continue;
+				}
+				depthRow[x] = z;
+				const float w = 1 / (weight[0] * t.inverseW[0] + weight[1] * t.inverseW[1] + weight[2] * t.inverseW[2]);
+				float rgba[4];
+				for (int j = 0; j < 4; ++j) {
+					rgba[j] = (weight[0] * t.color[0][j] + weight[1] * t.color[1][j] + weight[2] * t.color[2][j]) * w;
+				}
+				colorRow[x] = packColor(rgba);
+			}
+		}
+	}
+}
+
+const unsigned char* SoftwareRasterizer::getColor() const {
+	return (const unsigned char*)color.data();
+}
+
+const float* SoftwareRasterizer::getDepth() const {
+	return depth.data();
+}
+
+int SoftwareRasterizer::getWidth() const {
+	return width;
+}
+
+int SoftwareRasterizer::getHeight() const {
+	return height;
+}
+
+int SoftwareRasterizer::getTriangleCount() const {
+	return (int)triangles.size();
+}
+
+bool SoftwareRasterizer::writeImage(const string& path) const {
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		cout << "Unable to write image " << path << endl;
+		return false;
+	}
+	file << "P6\n" << width << " " << height << "\n255\n";
+	// Rows are stored from the bottom up, image rows go from the top down
+	std::vector<unsigned char> row((size_t)width * 3);
+	for (int y = height - 1; y >= 0; --y) {
+		const unsigned char* pixels = getColor() + (size_t)y * width * 4;
+		for (int x = 0; x < width; ++x) {
+			row[x * 3] = pixels[x * 4];
+			row[x * 3 + 1] = pixels[x * 4 + 1];
+			row[x * 3 + 2] = pixels[x * 4 + 2];
+		}
+		file.write((const char*)row.data(), row.size());
+	}
+	return file.good();
+}
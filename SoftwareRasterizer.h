@@ -0,0 +1,102 @@
+#pragma once
+#include <string>
+using std::string;
+#include <vector>
+#include "Matrix.h"
+#include "MeshRegistry.h"
+
+/// <summary>
+/// Draws meshes on the CPU, for machines with no GPU and no GL driver at all. It reads the same mesh records, instance
+/// data and matrices as the GL path and produces the same image as vertex.txt and fragment.txt: vertex colors times the
+/// shape's color, depth tested, back faces culled.
+///
+/// Each draw() transforms and clips the triangles of one level of detail and sorts them into 64x64 pixel tiles. rasterize()
+/// then gives whole tiles to worker threads, so no two threads ever touch the same pixel. Within a tile, edge functions
+/// and depth are evaluated four pixels at a time with SSE where available.
+///
+/// Usually driven by a RenderQueue, see RenderQueue::software. Per frame: clear(), draw() for each mesh, then rasterize().
+/// Edges and wireframe shapes are not drawn.
+/// </summary>
+class SoftwareRasterizer {
+public:
+	/// <summary> Whether to skip triangles wound clockwise on screen, like GL_CULL_FACE with GL_BACK. Can be modified directly. </summary>
+	bool cullBackFaces;
+
+	/// <summary> SoftwareRasterizer constructor. </summary>
+	/// <param name="width"> The width of the image, in pixels. </param>
+	/// <param name="height"> The height of the image, in pixels. </param>
+	/// <param name="threads"> The most threads rasterize() uses, or 0 for one per hardware thread. </param>
+	SoftwareRasterizer(const int& width, const int& height, const int& threads = 0);
+
+	/// <summary> Fills the image with a color and the depth buffer with the far plane. Forgets any triangles not yet rasterized. </summary>
+	void clear(const float& r, const float& g, const float& b, const float& a = 1);
+
+	/// <summary> Transforms, clips and bins one level of detail of a mesh. Nothing is drawn until rasterize(). </summary>
+	/// <param name="mesh"> The mesh to draw. Its source data is read, so it need not be uploaded. </param>
+	/// <param name="lod"> The level of detail to draw. </param>
+	/// <param name="instance"> The per-instance data, as GraphicsShape::writeInstance() writes it. </param>
+	/// <param name="viewProjection"> The projection matrix times the view matrix. </param>
+	void draw(const MeshRegistry::Mesh& mesh, const int& lod, const float* instance, const Matrix& viewProjection);
+
+	/// <summary> Draws every binned triangle into the image, one tile per thread at a time, then empties the bins. </summary>
+	void rasterize();
+
+	/// <summary> Returns the image as RGBA8, stored by row from the bottom up like glReadPixels(). </summary>
+	const unsigned char* getColor() const;
+	/// <summary> Returns the depth buffer, in [0, 1], stored by row from the bottom up. </summary>
+	const float* getDepth() const;
+	int getWidth() const;
+	int getHeight() const;
+	/// <summary> Returns the number of triangles binned since the last rasterize(), after culling and clipping. </summary>
+	int getTriangleCount() const;
+
+	/// <summary> Writes the image as a binary PPM, the same format as HeadlessContext::writeImage(). </summary>
+	/// <param name="path"> The file to write. </param>
+	/// <returns> Whether the file could be written. </returns>
+	bool writeImage(const string& path) const;
+
+private:
+	/// <summary> A vertex in clip space, with its color. </summary>
+	struct ClipVertex {
+		float x, y, z, w;
+		float color[4];
+	};
+
+	/// <summary> A triangle set up for rasterizing. The edge functions are scaled so that at a pixel center they give
+	/// that pixel's barycentric coordinates directly. </summary>
+	struct Triangle {
+		float edgeA[3], edgeB[3], edgeC[3];
+		/// <summary> The value each edge function must exceed: 0, or just under it for top and left edges, so pixels
+		/// exactly on an edge shared by two triangles are drawn by only one of them. </summary>
+		float threshold[3];
+		/// <summary> Window depth and 1 / w at each vertex. </summary>
+		float z[3], inverseW[3];
+		/// <summary> Each vertex's color divided by its w, so it can be interpolated with perspective. </summary>
+		float color[3][4];
+		/// <summary> The pixels the triangle may cover, inclusive. </summary>
+		int x0, y0, x1, y1;
+	};
+
+	static const int tileSize = 64;
+
+	int width, height, threads;
+	int tilesX, tilesY;
+	/// <summary> One RGBA8 pixel per value, so four can be written at once. </summary>
+	std::vector<unsigned int> color;
+	std::vector<float> depth;
+	std::vector<Triangle> triangles;
+	/// <summary> For each tile, the triangles that may touch it, in draw order. </summary>
+	std::vector<std::vector<unsigned int>> bins;
+	/// <summary> Vertices transformed by the current draw, and which draw each was transformed by, so a level of detail
+	/// that uses a few of a mesh's vertices only transforms those. </summary>
+	std::vector<ClipVertex> transformed;
+	std::vector<unsigned int> transformedDraw;
+	unsigned int drawCount;
+
+	/// <summary> Clips a triangle against the near plane, then sets up and bins what is left. </summary>
+	void addTriangle(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c);
+	/// <summary> Sets up and bins a triangle entirely in front of the near plane. </summary>
+	void setupTriangle(const ClipVertex* vertices);
+	/// <summary> Draws every triangle binned to one tile. </summary>
+	void rasterizeTile(const int& tile);
+};
@@ -3,12 +3,11 @@
 #include <ctime>
 #include <iostream>
 
-unsigned short Sphere::numVertices, * Sphere::numTriangleVertices, Sphere::numEdgeVertices;
-float* Sphere::vertices, * Sphere::colors, * Sphere::edgeColors;
-unsigned short** Sphere::triangles, * Sphere::edges;
-unsigned int Sphere::vertexColorBuffer, * Sphere::trianglesBuffers, Sphere::edgesBuffer, Sphere::edgeColorsBuffer, Sphere::facesVAO, Sphere::edgesVAO;
-bool Sphere::buffered = false, Sphere::initialized = false;
-char Sphere::maxLOD = 5;
+MeshHandle Sphere::classMesh;
+bool Sphere::initialized = false;
+char Sphere::maxLOD = 8;
+MeshCache Sphere::cache;
+const string Sphere::cachePath = "sphere.meshcache";
 
 Sphere::Sphere(const float& x, const float& y, const float& z, const float& sx, const float& sy, const float& sz, const float& rx, const float& ry, const float& rz) {
 	this->x = x;
@@ -23,102 +22,180 @@ Sphere::Sphere(const float& x, const float& y, const float& z, const float& sx,
 	this->currentLOD = 0;
 
 	if (!initialized) {
-		// Start by defining the octahedron.
-		// It has 6 vertices (represented by vectors here)
-		std::vector<Vector> verticesList = {
-			Vector(0.0f, 1.0f, 0.0f),
-			Vector(0.0f, 0.0f, 1.0f),
-			Vector(1.0f, 0.0f, 0.0f),
-			Vector(0.0f, 0.0f, -1.0f),
-			Vector(-1.0f, 0.0f, 0.0f),
-			Vector(0.0f, -1.0f, 0.0f)
-		};
-
-		std::map<unsigned int, unsigned short> verticesMap = {
-			{(unsigned int)0, 0},
-			{(unsigned short)1 << 16 | (unsigned int)1, 1},
-			{(unsigned short)2 << 16 | (unsigned int)2, 2},
-			{(unsigned short)3 << 16 | (unsigned int)3, 3},
-			{(unsigned short)4 << 16 | (unsigned int)4, 4},
-			{(unsigned short)5 << 16 | (unsigned int)5, 5}
-		};
-
-		std::vector<Triangle> trianglesList = {
-			Triangle(0, 1, 2),
-			Triangle(0, 2, 3),
-			Triangle(0, 3, 4),
-			Triangle(0, 4, 1),
-			Triangle(5, 1, 4),
-			Triangle(5, 4, 3),
-			Triangle(5, 3, 2),
-			Triangle(5, 2, 1),
-		};
-		
-		trianglesBuffers = new unsigned int[maxLOD + 1];
-		numTriangleVertices = new unsigned short[maxLOD + 1];
-		numTriangleVertices[0] = 24;
-
-		triangles = new unsigned short*[maxLOD + 1];
-		triangles[0] = new unsigned short[24]{
-			0, 1, 2,
-			0, 2, 3,
-			0, 3, 4,
-			0, 4, 1,
-			5, 1, 4,
-			5, 4, 3,
-			5, 3, 2,
-			5, 2, 1
-		};
-
-		createPoints(trianglesList, verticesList, verticesMap, numTriangleVertices, triangles);
-
-		numVertices = (unsigned short) verticesMap.size();
-		numEdgeVertices = 0;
-
-		vertices = new float[verticesList.size() * 3];
-
-		for (int i = 0; i < verticesList.size(); ++i) {
-			vertices[i * 3] = verticesList.at(i).getX();
-			vertices[i * 3 + 1] = verticesList.at(i).getY();
-			vertices[i * 3 + 2] = verticesList.at(i).getZ();
+		classMesh = MeshRegistry::create();
+		mesh = classMesh;
+		MeshRegistry::Mesh& data = MeshRegistry::get(classMesh);
+		data.maxLOD = maxLOD;
+		// The coarsest level is an octahedron, whose faces are 1 / sqrt(3) from its center. Finer levels only bulge outward.
+		data.innerRadius = 0.57735027f;
+		data.sphere = true;
+		// Generating every level takes a while, so it is only done when there is no usable cache
+		if (!loadCache()) {
+			generate();
+			saveCache();
 		}
+		initialized = true;
+	}
+	mesh = classMesh;
+}
+
+unsigned int Sphere::getCacheKey() {
+	// Anything that changes the generated mesh must change the key
+	const char generator[] = "Sphere octahedron subdivision, vertex cache and fetch optimized";
+	unsigned int key = MeshCache::checksum(generator, sizeof(generator));
+	return MeshCache::checksum(&maxLOD, sizeof(maxLOD), key);
+}
 
-		colors = new float[numVertices * 4];
+bool Sphere::loadCache() {
+	MeshRegistry::Mesh& data = MeshRegistry::get(classMesh);
+	if (!cache.open(cachePath, getCacheKey()) || cache.getLODs() != (unsigned int)maxLOD + 1) {
+		return false;
+	}
+	// Point straight into the mapped file. None of these are ever written to.
+	data.numVertices = cache.getNumVertices();
+	data.vertices = (float*)cache.getVertices();
+	data.colors = (float*)cache.getColors();
+	data.numEdgeVertices = 0;
+	data.numTriangleVertices = new unsigned int[maxLOD + 1];
+	data.triangles = new unsigned int*[maxLOD + 1];
+	data.lodErrors = new float[maxLOD + 1];
+	for (int lod = 0; lod <= maxLOD; ++lod) {
+		data.numTriangleVertices[lod] = cache.getNumIndices(lod);
+		data.triangles[lod] = (unsigned int*)cache.getIndices(lod);
+		data.lodErrors[lod] = cache.getError(lod);
+	}
+	return true;
+}
+
+void Sphere::saveCache() {
+	MeshRegistry::Mesh& data = MeshRegistry::get(classMesh);
+	unsigned int* numIndices = new unsigned int[maxLOD + 1];
+	for (int lod = 0; lod <= maxLOD; ++lod) {
+		numIndices[lod] = data.numTriangleVertices[lod];
+	}
+	MeshCache::write(cachePath, getCacheKey(), data.numVertices, data.vertices, data.colors, maxLOD + 1, numIndices, data.triangles, data.lodErrors);
+	delete[] numIndices;
+}
 
-		srand((unsigned int)time(0));
+void Sphere::generate() {
+	MeshRegistry::Mesh& data = MeshRegistry::get(classMesh);
+	// Each subdivision splits every edge once, so level L ends up with 4 * 4^L + 2 vertices and 12 * 4^L edges
+	const size_t finalVertices = ((size_t)4 << (2 * maxLOD)) + 2;
+
+	// Start by defining the octahedron.
+	// It has 6 vertices (represented by vectors here)
+	std::vector<Vector> verticesList;
+	verticesList.reserve(finalVertices);
+	verticesList.push_back(Vector(0.0f, 1.0f, 0.0f));
+	verticesList.push_back(Vector(0.0f, 0.0f, 1.0f));
+	verticesList.push_back(Vector(1.0f, 0.0f, 0.0f));
+	verticesList.push_back(Vector(0.0f, 0.0f, -1.0f));
+	verticesList.push_back(Vector(-1.0f, 0.0f, 0.0f));
+	verticesList.push_back(Vector(0.0f, -1.0f, 0.0f));
+
+	// Every midpoint ever made becomes a vertex, which bounds the number of edges the cache sees
+	MidPointCache midPoints(finalVertices);
+
+	std::vector<Triangle> trianglesList = {
+		Triangle(0, 1, 2),
+		Triangle(0, 2, 3),
+		Triangle(0, 3, 4),
+		Triangle(0, 4, 1),
+		Triangle(5, 1, 4),
+		Triangle(5, 4, 3),
+		Triangle(5, 3, 2),
+		Triangle(5, 2, 1),
+	};
+	
+	data.numTriangleVertices = new unsigned int[maxLOD + 1];
+	data.numTriangleVertices[0] = 24;
+
+	data.triangles = new unsigned int*[maxLOD + 1];
+	data.triangles[0] = new unsigned int[24]{
+		0, 1, 2,
+		0, 2, 3,
+		0, 3, 4,
+		0, 4, 1,
+		5, 1, 4,
+		5, 4, 3,
+		5, 3, 2,
+		5, 2, 1
+	};
+
+	createPoints(trianglesList, verticesList, midPoints, data.numTriangleVertices, data.triangles);
+
+	data.numVertices = (unsigned int) verticesList.size();
+	data.numEdgeVertices = 0;
+
+	data.vertices = new float[verticesList.size() * 3];
+
+	for (size_t i = 0; i < verticesList.size(); ++i) {
+		data.vertices[i * 3] = verticesList.at(i).getX();
+		data.vertices[i * 3 + 1] = verticesList.at(i).getY();
+		data.vertices[i * 3 + 2] = verticesList.at(i).getZ();
+	}
 
-		for (int i = 0; i < numVertices * 4; i += 4) {
-			colors[i] = rand() % 100 / 100.0f;
-			colors[i + 1] = rand() % 100 / 100.0f;
-			colors[i + 2] = rand() % 100 / 100.0f;
-			colors[i + 3] = 0.0f;
+	// Every vertex is on the unit sphere, so a triangle strays farthest at its plane's closest point to the center
+	data.lodErrors = new float[maxLOD + 1];
+	for (int lod = 0; lod <= maxLOD; ++lod) {
+		data.lodErrors[lod] = 0;
+		for (unsigned int i = 0; i < data.numTriangleVertices[lod]; i += 3) {
+			const Vector& a = verticesList[data.triangles[lod][i]];
+			const Vector normal = (verticesList[data.triangles[lod][i + 1]] - a) % (verticesList[data.triangles[lod][i + 2]] - a);
+			const float error = 1 - fabsf(normal * a) / normal.mag();
+			if (error > data.lodErrors[lod]) {
+				data.lodErrors[lod] = error;
+			}
 		}
+	}
 
-		initialized = true;
+	data.colors = new float[data.numVertices * 4];
+
+	srand((unsigned int)time(0));
+
+	for (unsigned int i = 0; i < data.numVertices * 4; i += 4) {
+		data.colors[i] = rand() % 100 / 100.0f;
+		data.colors[i + 1] = rand() % 100 / 100.0f;
+		data.colors[i + 2] = rand() % 100 / 100.0f;
+		data.colors[i + 3] = 0.0f;
+	}
+
+	// Subdivision order scatters each triangle's neighbours across the list
+	optimizeMesh("Sphere");
+}
+
+Sphere::MidPointCache::MidPointCache(const size_t& capacity) {
+	// At most half full, so probe sequences stay short
+	bits = 4;
+	while (((size_t)1 << bits) < capacity * 2) {
+		++bits;
 	}
+	keys.assign((size_t)1 << bits, ~0ull);
+	values.resize((size_t)1 << bits);
 }
 
 void Sphere::createPoints(
 	std::vector<Triangle>& trianglesList,
 	std::vector<Vector>& verticesList,
-	std::map<unsigned int,
-	unsigned short>& verticesMap,
-	unsigned short * const& numTriangleVertices,
-	unsigned short * * const& triangles
+	MidPointCache& midPoints,
+	unsigned int * const& numTriangleVertices,
+	unsigned int * * const& triangles
 ) {
+	std::vector<Triangle> newTriangles;
 	for (int i = 0; i < maxLOD; ++i) {
-		std::vector<Triangle> newTriangles;
+		newTriangles.clear();
+		newTriangles.reserve(trianglesList.size() * 4);
 		for (std::vector<Triangle>::iterator i = trianglesList.begin(); i < trianglesList.end(); ++i) {
-			unsigned int ab = getMidPoint((*i).a, (*i).b, verticesList, verticesMap);
-			unsigned int bc = getMidPoint((*i).b, (*i).c, verticesList, verticesMap);
-			unsigned int ac = getMidPoint((*i).a, (*i).c, verticesList, verticesMap);
+			unsigned int ab = getMidPoint((*i).a, (*i).b, verticesList, midPoints);
+			unsigned int bc = getMidPoint((*i).b, (*i).c, verticesList, midPoints);
+			unsigned int ac = getMidPoint((*i).a, (*i).c, verticesList, midPoints);
 			newTriangles.push_back(Triangle((*i).a, ab, ac));
 			newTriangles.push_back(Triangle((*i).b, bc, ab));
 			newTriangles.push_back(Triangle((*i).c, ac, bc));
 			newTriangles.push_back(Triangle(ab, bc, ac));
 		}
-		numTriangleVertices[i + 1] = (unsigned short) newTriangles.size() * 3;
-		triangles[i + 1] = new unsigned short[newTriangles.size() * 3];
+		numTriangleVertices[i + 1] = (unsigned int) newTriangles.size() * 3;
+		triangles[i + 1] = new unsigned int[newTriangles.size() * 3];
 		int index = 0;
 		for (std::vector<Triangle>::iterator iterator = newTriangles.begin(); iterator != newTriangles.end(); ++iterator) {
 			triangles[i + 1][index] = (*iterator).a;
@@ -126,57 +203,25 @@ void Sphere::createPoints(
 			triangles[i + 1][index + 2] = (*iterator).c;
 			index += 3;
 		}
-		trianglesList = newTriangles;
+		trianglesList.swap(newTriangles);
 	}
 }
 
-unsigned short Sphere::getMidPoint(unsigned short a, unsigned short b, std::vector<Vector>& verticesList, std::map<unsigned int, unsigned short>& verticesMap) {
-	unsigned short lower = a < b ? a : b;
-	unsigned short higher = a >= b ? a : b;
-	unsigned int key = lower << 16 | higher;
-	std::map<unsigned int, unsigned short>::iterator result = verticesMap.find(key);
-	if (result == verticesMap.end()) {
-		verticesList.push_back(~(verticesList[a] + verticesList[b]));
-		verticesMap.insert(std::pair<unsigned int, unsigned short>(key, verticesList.size() - 1));
-		return (unsigned short) verticesList.size() - 1;
-	}
-	else {
-		return (*result).second;
+unsigned int Sphere::getMidPoint(unsigned int a, unsigned int b, std::vector<Vector>& verticesList, MidPointCache& midPoints) {
+	unsigned int lower = a < b ? a : b;
+	unsigned int higher = a >= b ? a : b;
+	unsigned long long key = (unsigned long long)lower << 32 | higher;
+	// Fibonacci hashing spreads the neighbouring indices of an edge across the table
+	const size_t mask = midPoints.keys.size() - 1;
+	size_t slot = (size_t)((key * 0x9E3779B97F4A7C15ull) >> (64 - midPoints.bits));
+	while (midPoints.keys[slot] != ~0ull) {
+		if (midPoints.keys[slot] == key) {
+			return midPoints.values[slot];
+		}
+		slot = (slot + 1) & mask;
 	}
+	verticesList.push_back(~(verticesList[a] + verticesList[b]));
+	midPoints.keys[slot] = key;
+	midPoints.values[slot] = (unsigned int) verticesList.size() - 1;
+	return midPoints.values[slot];
 }
-
-void Sphere::drawTriangles() {
-	glDrawElements(GL_TRIANGLES, getNumTriangleVertices()[currentLOD], GL_UNSIGNED_SHORT, (void*)0);
-}
-
-char& Sphere::getMaxLOD() const { return maxLOD; }
-
-unsigned short& Sphere::getNumVertices() const { return numVertices; }
-
-unsigned short*& Sphere::getNumTriangleVertices() const { return numTriangleVertices; }
-
-unsigned short& Sphere::getNumEdgeVertices() const { return numEdgeVertices; }
-
-float*& Sphere::getVertices() const { return vertices; }
-
-float*& Sphere::getColors() const { return colors; }
-
-float*& Sphere::getEdgeColors() const { return edgeColors; }
-
-unsigned short**& Sphere::getTriangles() const { return triangles; }
-
-unsigned short*& Sphere::getEdges() const { return edges; }
-
-unsigned int& Sphere::getVertexColorBuffer() const { return vertexColorBuffer; }
-
-unsigned int*& Sphere::getTrianglesBuffers() const { return trianglesBuffers; }
-
-unsigned int& Sphere::getEdgesBuffer() const { return edgesBuffer; }
-
-unsigned int& Sphere::getEdgeColorsBuffer() const { return edgeColorsBuffer; }
-
-unsigned int& Sphere::getFacesVAO() const { return facesVAO; }
-
-unsigned int& Sphere::getEdgesVAO() const { return edgesVAO; }
-
-bool& Sphere::getBuffered() const { return buffered; }
\ No newline at end of file
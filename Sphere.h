@@ -1,6 +1,6 @@
 #pragma once
 #include "GraphicsShape.h"
-#include <map>
+#include "MeshCache.h"
 #include <vector>
 
 /// <summary> A child of GraphicsShape, to represent any Sphere. </summary>
@@ -17,61 +17,48 @@ public:
 	/// <param name="ry"> The y-rotation of this sphere, in radians. </param>
 	/// <param name="rz"> The z-rotation of this sphere, in radians. </param>
 	Sphere(const float& x = 0, const float& y = 0, const float& z = 0, const float& sx = 1, const float& sy = 1, const float& sz = 1, const float& rx = 0, const float& ry = 0, const float& rz = 0);
-
-	void drawTriangles() override;
 private:
 	struct Triangle {
-		unsigned short a, b, c;
-		Triangle(unsigned short a, unsigned short b, unsigned short c) : a(a), b(b), c(c) {}
+		unsigned int a, b, c;
+		Triangle(unsigned int a, unsigned int b, unsigned int c) : a(a), b(b), c(c) {}
+	};
+
+	/// <summary> Maps an edge, as its two vertex indices, to the vertex at its midpoint.
+	/// An open addressing hash table sized up front, since the number of edges is known before subdividing. </summary>
+	struct MidPointCache {
+		std::vector<unsigned long long> keys;
+		std::vector<unsigned int> values;
+		int bits;
+		/// <summary> MidPointCache constructor. </summary>
+		/// <param name="capacity"> The most edges that will be added. </param>
+		MidPointCache(const size_t& capacity);
 	};
 
-	static unsigned short numVertices, * numTriangleVertices, numEdgeVertices;
-	static float* vertices, * colors, * edgeColors;
-	static unsigned short** triangles, * edges;
-	static unsigned int vertexColorBuffer, * trianglesBuffers, edgesBuffer, edgeColorsBuffer, facesVAO, edgesVAO;
-	static bool buffered, initialized;
+	/// <summary> The mesh every sphere draws. </summary>
+	static MeshHandle classMesh;
+	static bool initialized;
+	/// <summary> The finest level of detail generated. </summary>
 	static char maxLOD;
+	/// <summary> The generated levels, saved so later runs can skip generating them. </summary>
+	static MeshCache cache;
+	static const string cachePath;
+
+	/// <summary> Identifies how the mesh is generated, so a cache made with different settings is not used. </summary>
+	static unsigned int getCacheKey();
+	/// <summary> Points the class data into the cache file, if there is a usable one. </summary>
+	bool loadCache();
+	/// <summary> Saves the class data to the cache file. </summary>
+	void saveCache();
+	/// <summary> Builds every level of detail by subdividing an octahedron, and picks random vertex colors. </summary>
+	void generate();
 
 	void createPoints(
 		std::vector<Triangle>&,
 		std::vector<Vector>&,
-		std::map<unsigned int,
-		unsigned short>&,
-		unsigned short * const&,
-		unsigned short * * const&
+		MidPointCache&,
+		unsigned int * const&,
+		unsigned int * * const&
 	);
 
-	char& getMaxLOD() const override;
-
-	unsigned short getMidPoint(unsigned short a, unsigned short b, std::vector<Vector>&, std::map<unsigned int, unsigned short>&);
-
-	unsigned short& getNumVertices() const override;
-
-	unsigned short*& getNumTriangleVertices() const override;
-
-	unsigned short& getNumEdgeVertices() const override;
-
-	float*& getVertices() const override;
-
-	float*& getColors() const override;
-
-	float*& getEdgeColors() const override;
-
-	unsigned short**& getTriangles() const override;
-
-	unsigned short*& getEdges() const override;
-
-	unsigned int& getVertexColorBuffer() const override;
-
-	unsigned int*& getTrianglesBuffers() const override;
-
-	unsigned int& getEdgesBuffer() const override;
-
-	unsigned int& getEdgeColorsBuffer() const override;
-
-	unsigned int& getFacesVAO() const override;
-
-	unsigned int& getEdgesVAO() const override;
-
-	bool& getBuffered() const override;
+	unsigned int getMidPoint(unsigned int a, unsigned int b, std::vector<Vector>&, MidPointCache&);
 };
\ No newline at end of file
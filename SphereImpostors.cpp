@@ -0,0 +1,72 @@
+#include "SphereImpostors.h"
+#include <cstring>
+
+SphereImpostors::SphereImpostors() : instanceStream(GL_ARRAY_BUFFER) {
+	programLoaded = false;
+	programStarted = false;
+	sphereAttribute = -1;
+	vertexArray = 0;
+}
+
+void SphereImpostors::add(const float& x, const float& y, const float& z, const float& radius, const float* color) {
+	const float instance[instanceFloats] = { x, y, z, radius, color[0], color[1], color[2], color[3] };
+	instances.insert(instances.end(), instance, instance + instanceFloats);
+}
+
+int SphereImpostors::getCount() const {
+	return (int)(instances.size() / instanceFloats);
+}
+
+void SphereImpostors::preload() {
+	if (programStarted) {
+		return;
+	}
+	pendingProgram = startProgram("impostorVertex.txt", "impostorFragment.txt");
+	programStarted = true;
+}
+
+bool SphereImpostors::isReady() const {
+	return programLoaded || !programStarted || isProgramReady(pendingProgram);
+}
+
+void SphereImpostors::release() {
+	instanceStream.destroy();
+}
+
+void SphereImpostors::draw() {
+	const int count = getCount();
+	if (count == 0) {
+		return;
+	}
+	if (!programLoaded) {
+		preload();
+		program = finishShaderProgram(pendingProgram);
+		sphereAttribute = glGetAttribLocation(program.id, "impostorSphere");
+		glGenVertexArrays(1, &vertexArray);
+		glBindVertexArray(vertexArray);
+		glVertexAttribDivisor(sphereAttribute, 1);
+		glEnableVertexAttribArray(sphereAttribute);
+		glVertexAttribDivisor(program.instanceColorAttribute, 1);
+		glEnableVertexAttribArray(program.instanceColorAttribute);
+		glBindVertexArray(0);
+		programLoaded = true;
+	}
+
+	const size_t bytes = sizeof(float) * instances.size();
+	instanceStream.reserve(bytes);
+	instanceStream.beginFrame();
+	size_t offset = 0;
+	memcpy(instanceStream.allocate(bytes, offset), instances.data(), bytes);
+	instanceStream.commit();
+	instances.clear();
+
+	glUseProgram(program.id);
+	glBindVertexArray(vertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceStream.getBuffer());
+	const int stride = sizeof(float) * instanceFloats;
+	glVertexAttribPointer(sphereAttribute, 4, GL_FLOAT, false, stride, (void*)offset);
+	glVertexAttribPointer(program.instanceColorAttribute, 4, GL_FLOAT, false, stride, (void*)(offset + sizeof(float) * 4));
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+	glBindVertexArray(0);
+	glUseProgram(0);
+}
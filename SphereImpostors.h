@@ -0,0 +1,57 @@
+#pragma once
+#include <vector>
+#include "DynamicBuffer.h"
+#include "WebGLUtility.h"
+
+/// <summary>
+/// Draws spheres without their meshes. Each sphere is a quad facing the camera, just large enough to cover it, and the
+/// fragment shader casts a ray through every pixel of the quad to find the exact surface, its normal and its depth.
+/// The vertex work is four vertices per sphere however close it gets, and the silhouette is perfectly round at any size.
+///
+/// Instances are only a center, a radius and a color, so every sphere added in a frame is drawn with one instanced draw.
+/// Spheres are lit from the camera, since there is no surface color to show otherwise.
+///
+/// Per frame: add() each sphere, then draw() with the Frame uniform block bound, see FrameUniforms.
+/// </summary>
+class SphereImpostors {
+public:
+	/// <summary> The number of floats of per-instance data: the center and radius, then an RGBA color. </summary>
+	static const int instanceFloats = 8;
+
+	SphereImpostors();
+
+	/// <summary> Queues a sphere for the next draw(). </summary>
+	/// <param name="x"> The x-coord of the sphere's center. </param>
+	/// <param name="y"> The y-coord of the sphere's center. </param>
+	/// <param name="z"> The z-coord of the sphere's center. </param>
+	/// <param name="radius"> The radius of the sphere. </param>
+	/// <param name="color"> The RGBA color of the sphere. </param>
+	void add(const float& x, const float& y, const float& z, const float& radius, const float* color);
+
+	/// <summary> Returns the number of spheres queued since the last draw(). </summary>
+	int getCount() const;
+
+	/// <summary> Draws every queued sphere, then empties the queue. Loads the program the first time, unless preload() started it. </summary>
+	void draw();
+
+	/// <summary> Starts building the program, so the first draw() does not wait for the compiler. Does nothing once started. </summary>
+	void preload();
+
+	/// <summary> Returns false while a program started by preload() is still compiling on the driver's threads, when draw()
+	/// would have to wait for it. </summary>
+	bool isReady() const;
+
+	/// <summary> Deletes the instance buffer, for when the context is destroyed before this. GL thread only. </summary>
+	void release();
+
+private:
+	ShaderProgram program;
+	bool programLoaded;
+	PendingProgram pendingProgram;
+	bool programStarted;
+	int sphereAttribute;
+	/// <summary> Has no vertex buffers: the corners of each quad come from gl_VertexID. </summary>
+	unsigned int vertexArray;
+	std::vector<float> instances;
+	DynamicBuffer instanceStream;
+};
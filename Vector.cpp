@@ -120,7 +120,19 @@ Vector& Vector::operator%=(const Vector& rhs) {
 }
 
 Vector Vector::operator~() const {
-	const float len = mag();
+	return normalized<PreciseMath>();
+}
+
+template<class Math>
+Vector Vector::normalized() const {
+	const float inv = Math::rsqrt(mag2());
+	return Vector(values[0] * inv, values[1] * inv, values[2] * inv);
+}
+
+// Dividing by the correctly rounded length rounds once per component, where multiplying by 1 / length rounds twice
+template<>
+Vector Vector::normalized<PreciseMath>() const {
+	const float len = mag<PreciseMath>();
 	float arr[] = {
 		values[0] / len,
 		values[1] / len,
@@ -151,7 +163,12 @@ bool Vector::nearlyEquals(const Vector& rhs, const float& tolerance) const {
 }
 
 float Vector::mag() const {
-	return sqrtf(values[0] * values[0] + values[1] * values[1] + values[2] * values[2]);
+	return mag<PreciseMath>();
+}
+
+template<class Math>
+float Vector::mag() const {
+	return Math::sqrt(mag2());
 }
 
 float Vector::mag2() const {
@@ -159,7 +176,20 @@ float Vector::mag2() const {
 }
 
 void Vector::normalize() {
-	const float len = mag();
+	normalize<PreciseMath>();
+}
+
+template<class Math>
+void Vector::normalize() {
+	const float inv = Math::rsqrt(mag2());
+	values[0] *= inv;
+	values[1] *= inv;
+	values[2] *= inv;
+}
+
+template<>
+void Vector::normalize<PreciseMath>() {
+	const float len = mag<PreciseMath>();
 	values[0] /= len;
 	values[1] /= len;
 	values[2] /= len;
@@ -179,4 +209,9 @@ float Vector::getY() const {
 /// <summary> Gets the z component of the vector. </summary>
 float Vector::getZ() const {
 	return values[2];
-}
\ No newline at end of file
+}
+
+template Vector Vector::normalized<FastMath>() const;
+template float Vector::mag<PreciseMath>() const;
+template float Vector::mag<FastMath>() const;
+template void Vector::normalize<FastMath>();
\ No newline at end of file
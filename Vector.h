@@ -1,5 +1,6 @@
 #pragma once
 #include <cmath>
+#include "MathPolicy.h"
 class Vector {
 private:
 	float values[4] = { 0,0,0,1 };
@@ -45,6 +46,8 @@ public:
 	Vector& operator%=(const Vector&);
 	/// <summary> Normalized vector. </summary>
 	Vector operator~() const;
+	/// <summary> Normalized vector, computed with the math tier <typeparamref name="Math"/>. </summary>
+	template<class Math> Vector normalized() const;
 	/// <summary> Negated vector. </summary>
 	Vector operator-() const;
 	/// <summary> Value accessor. </summary>
@@ -57,10 +60,14 @@ public:
 	bool nearlyEquals(const Vector& rhs, const float& tolerance) const;
 	/// <summary> Magnitude. </summary>
 	float mag() const;
+	/// <summary> Magnitude, computed with the math tier <typeparamref name="Math"/>. </summary>
+	template<class Math> float mag() const;
 	/// <summary> Square magnitude. </summary>
 	float mag2() const;
 	/// <summary> Normalizes this vector. </summary>
 	void normalize();
+	/// <summary> Normalizes this vector with the math tier <typeparamref name="Math"/>. </summary>
+	template<class Math> void normalize();
 	/// <summary> Gets the underlying vector values. </summary>
 	const float* getValues() const;
 	/// <summary> Gets the x component of the vector. </summary>
@@ -69,4 +76,8 @@ public:
 	float getY() const;
 	/// <summary> Gets the z component of the vector. </summary>
 	float getZ() const;
-};
\ No newline at end of file
+};
+
+// PreciseMath divides by the length rather than multiplying by its reciprocal, see Vector.cpp
+template<> Vector Vector::normalized<PreciseMath>() const;
+template<> void Vector::normalize<PreciseMath>();
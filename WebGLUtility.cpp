@@ -1,102 +1,391 @@
 #include "WebGLUtility.h"
+#include "MeshCache.h"
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+GLExtensions::BufferStorageProc GLExtensions::bufferStorage = nullptr;
+GLExtensions::GetProgramBinaryProc GLExtensions::getProgramBinary = nullptr;
+GLExtensions::ProgramBinaryProc GLExtensions::programBinary = nullptr;
+GLExtensions::ProgramParameteriProc GLExtensions::programParameteri = nullptr;
+GLExtensions::MaxShaderCompilerThreadsProc GLExtensions::maxShaderCompilerThreads = nullptr;
+
+bool ProgramCache::enabled = true;
+string ProgramCache::prefix = "";
+
+void loadExtensions(GLADloadproc load) {
+	if (hasVersion(4, 4) || hasExtension("GL_ARB_buffer_storage")) {
+		GLExtensions::bufferStorage = (GLExtensions::BufferStorageProc)load("glBufferStorage");
+	}
+	// Drivers may support the entry points yet offer no format to save programs in
+	int binaryFormats = 0;
+	if (hasVersion(4, 1) || hasExtension("GL_ARB_get_program_binary")) {
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+	}
+	if (binaryFormats > 0) {
+		GLExtensions::getProgramBinary = (GLExtensions::GetProgramBinaryProc)load("glGetProgramBinary");
+		GLExtensions::programBinary = (GLExtensions::ProgramBinaryProc)load("glProgramBinary");
+		GLExtensions::programParameteri = (GLExtensions::ProgramParameteriProc)load("glProgramParameteri");
+	}
+	if (hasExtension("GL_KHR_parallel_shader_compile")) {
+		GLExtensions::maxShaderCompilerThreads = (GLExtensions::MaxShaderCompilerThreadsProc)load("glMaxShaderCompilerThreadsKHR");
+	}
+	else if (hasExtension("GL_ARB_parallel_shader_compile")) {
+		GLExtensions::maxShaderCompilerThreads = (GLExtensions::MaxShaderCompilerThreadsProc)load("glMaxShaderCompilerThreadsARB");
+	}
+	if (GLExtensions::maxShaderCompilerThreads != nullptr) {
+		// Let the driver choose how many threads to compile on
+		GLExtensions::maxShaderCompilerThreads(0xFFFFFFFF);
+	}
+}
+
+bool hasExtension(const char* name) {
+	int count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (int i = 0; i < count; ++i) {
+		const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+		if (extension != nullptr && string(extension) == name) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool hasVersion(const int& major, const int& minor) {
+	int contextMajor = 0, contextMinor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &contextMajor);
+	glGetIntegerv(GL_MINOR_VERSION, &contextMinor);
+	return contextMajor > major || (contextMajor == major && contextMinor >= minor);
+}
 
 string getShader(string path) {
-	ifstream file;
-	file.open(path);
-	if (file.is_open()) {
-		string shader = "";
-		string line = "";
-		while (!file.eof()) {
-			getline(file, line);
-			shader += line + '\n';
+	// Binary, so the size read is the size on disk
+	ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open()) {
+		cout << "Unable to open shader file at path: " << path << endl;
+		throw std::runtime_error("Unable to open shader.");
+	}
+	string shader((size_t)file.tellg(), '\0');
+	file.seekg(0);
+	file.read(&shader[0], shader.size());
+	return shader;
+}
+
+namespace {
+	/// <summary> The start of a ProgramCache file, followed by the driver string and then the program binary. </summary>
+	struct ProgramCacheHeader {
+		char magic[4];
+		/// <summary> A hash of every source, and their total length, to catch edited shaders. </summary>
+		unsigned int sourceHash;
+		unsigned int sourceBytes;
+		unsigned int driverBytes;
+		unsigned int binaryFormat;
+		unsigned int binaryBytes;
+	};
+
+	const char programCacheMagic[4] = { 'P', 'R', 'G', '1' };
+
+	/// <summary> Identifies the driver, since a program binary is only valid for the driver that produced it. </summary>
+	string getDriver() {
+		const char* vendor = (const char*)glGetString(GL_VENDOR);
+		const char* renderer = (const char*)glGetString(GL_RENDERER);
+		const char* version = (const char*)glGetString(GL_VERSION);
+		return string(vendor ? vendor : "") + "|" + (renderer ? renderer : "") + "|" + (version ? version : "");
+	}
+
+	/// <summary> Returns the cache file of the program built from these shader files. </summary>
+	string getProgramCachePath(const string& vertex, const string& fragment, const string& geometry) {
+		const string paths = vertex + "|" + fragment + "|" + geometry;
+		char name[32];
+		snprintf(name, sizeof(name), "%08x.programcache", MeshCache::checksum(paths.data(), paths.size()));
+		return ProgramCache::prefix + name;
+	}
+
+	/// <summary> Creates a program from a cache file, if there is one matching these sources and this driver. </summary>
+	/// <returns> The linked program, or 0 if there was no usable file. </returns>
+	unsigned int loadProgramBinary(const string& path, const unsigned int& sourceHash, const unsigned int& sourceBytes, const string& driver) {
+		ifstream file(path, std::ios::binary);
+		if (!file.is_open()) {
+			return 0;
+		}
+		ProgramCacheHeader header;
+		if (!file.read((char*)&header, sizeof(header)) || memcmp(header.magic, programCacheMagic, sizeof(header.magic)) != 0
+			|| header.sourceHash != sourceHash || header.sourceBytes != sourceBytes || header.driverBytes != driver.size()) {
+			return 0;
 		}
+		string fileDriver(header.driverBytes, '\0');
+		std::vector<char> binary(header.binaryBytes);
+		if (!file.read(&fileDriver[0], fileDriver.size()) || fileDriver != driver || !file.read(binary.data(), binary.size())) {
+			return 0;
+		}
+		const unsigned int program = glCreateProgram();
+		GLExtensions::programBinary(program, header.binaryFormat, binary.data(), (GLsizei)binary.size());
+		// Drivers may still refuse a binary, for example after an update that kept the version string
+		int isLinked = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &isLinked);
+		if (isLinked == GL_FALSE) {
+			glDeleteProgram(program);
+			return 0;
+		}
+		return program;
+	}
+
+	/// <summary> Writes a linked program to its cache file. Failing to is not an error, the next launch just compiles again. </summary>
+	void saveProgramBinary(const unsigned int& program, const string& path, const unsigned int& sourceHash, const unsigned int& sourceBytes, const string& driver) {
+		int length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0) {
+			return;
+		}
+		std::vector<char> binary(length);
+		GLenum format = 0;
+		GLExtensions::getProgramBinary(program, length, &length, &format, binary.data());
+		ProgramCacheHeader header;
+		memcpy(header.magic, programCacheMagic, sizeof(header.magic));
+		header.sourceHash = sourceHash;
+		header.sourceBytes = sourceBytes;
+		header.driverBytes = (unsigned int)driver.size();
+		header.binaryFormat = format;
+		header.binaryBytes = (unsigned int)length;
+		// Write beside the real file and swap it in, so a crash or another instance never leaves half a binary for
+		// glProgramBinary(). The name is the process's own, so two instances never write the same temporary file.
+		char suffix[32];
+#ifdef _WIN32
+		snprintf(suffix, sizeof(suffix), ".%lu.tmp", (unsigned long)GetCurrentProcessId());
+#else
+		snprintf(suffix, sizeof(suffix), ".%ld.tmp", (long)getpid());
+#endif
+		const string temporary = path + suffix;
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		file.write((const char*)&header, sizeof(header));
+		file.write(driver.data(), driver.size());
+		file.write(binary.data(), length);
 		file.close();
+		if (file.fail()) {
+			std::remove(temporary.c_str());
+			return;
+		}
+#ifdef _WIN32
+		if (!MoveFileExA(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+#else
+		if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+#endif
+			std::remove(temporary.c_str());
+		}
+	}
+
+	/// <summary> Creates a shader and starts compiling it. Whether it compiled is only asked in checkShader(), since
+	/// asking waits for the compiler. </summary>
+	/// <param name="type"> The stage, such as GL_VERTEX_SHADER. </param>
+	/// <param name="source"> The source of the shader. </param>
+	unsigned int startShader(const GLenum& type, const string& source) {
+		unsigned int shader = glCreateShader(type);
+		const char* sourceCString = source.c_str();
+		// Add the source string to the shader object and compile it
+		glShaderSource(shader, 1, &sourceCString, 0);
+		glCompileShader(shader);
 		return shader;
 	}
-	else {
-		cout << "Unable to open shader file at path: " << path << endl;
-		throw new std::runtime_error("Unable to open shader.");
+
+	/// <summary> Checks whether a shader compiled, and prints its log if not. </summary>
+	/// <param name="shader"> The shader, or 0 for a stage the program does not have. </param>
+	/// <param name="stage"> The name of the stage, for the error message. </param>
+	bool checkShader(const unsigned int& shader, const string& stage) {
+		if (shader == 0) {
+			return true;
+		}
+		int isCompiled = false;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &isCompiled);
+		if (!isCompiled) {
+			int maxLength = 0;
+			glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &maxLength);
+
+			// The maxLength includes the NULL character
+			char* infoLog = new char[maxLength];
+			glGetShaderInfoLog(shader, maxLength, &maxLength, &infoLog[0]);
+			cout << stage << " shader failed to compile:" << endl;
+			cout << infoLog;
+			delete[] infoLog;
+			return false;
+		}
+		return true;
+	}
+
+	/// <summary> Detaches and deletes the shaders of a program, which is linked or being thrown away. </summary>
+	void deleteShaders(PendingProgram& program) {
+		const unsigned int shaders[3] = { program.vertexShader, program.fragmentShader, program.geometryShader };
+		for (int i = 0; i < 3; ++i) {
+			if (shaders[i] != 0) {
+				glDetachShader(program.id, shaders[i]);
+				glDeleteShader(shaders[i]);
+			}
+		}
+		program.vertexShader = 0;
+		program.fragmentShader = 0;
+		program.geometryShader = 0;
+	}
+
+	/// <summary> Names a glGetError() code. This stands in for gluErrorString(), so GLU is not needed. </summary>
+	const char* errorName(const GLenum& error) {
+		switch (error) {
+		case GL_INVALID_ENUM: return "GL_INVALID_ENUM";
+		case GL_INVALID_VALUE: return "GL_INVALID_VALUE";
+		case GL_INVALID_OPERATION: return "GL_INVALID_OPERATION";
+		case GL_INVALID_FRAMEBUFFER_OPERATION: return "GL_INVALID_FRAMEBUFFER_OPERATION";
+		case GL_OUT_OF_MEMORY: return "GL_OUT_OF_MEMORY";
+		default: return "Unknown error";
+		}
 	}
 }
 
-unsigned int createProgram(string vertex, string fragment) {
-	// Create program and shader objects
-	unsigned int program = glCreateProgram();
-	unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	// Retrieve vertex and fragment source strings
-	string vertexSourceString = getShader(vertex);
-	string fragmentSourceString = getShader(fragment);
-	// Convert strings to c-style
-	const char* vertexSourceCString = vertexSourceString.c_str();
-	const char* fragmentSourceCString = fragmentSourceString.c_str();
-	// Add the source strings to the shader objects
-	glShaderSource(vertexShader, 1, &vertexSourceCString, 0);
-	glShaderSource(fragmentShader, 1, &fragmentSourceCString, 0);
-	// Compile the shaders
-	glCompileShader(vertexShader);
-	glCompileShader(fragmentShader);
-	int isCompiled = false;
-	glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &isCompiled);
-	if (!isCompiled) {
-		int maxLength = 0;
-		glGetShaderiv(vertexShader, GL_INFO_LOG_LENGTH, &maxLength);
-
-		// The maxLength includes the NULL character
-		char* infoLog = new char[maxLength];
-		glGetShaderInfoLog(vertexShader, maxLength, &maxLength, &infoLog[0]);
-		cout << "Vertex shader failed to compile:" << endl;
-		cout << infoLog;
-		delete[] infoLog;
-		throw new std::runtime_error("Vertex shader failed to compile.");
-	}
-	glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &isCompiled);
-	if (!isCompiled) {
-		int maxLength = 0;
-		glGetShaderiv(fragmentShader, GL_INFO_LOG_LENGTH, &maxLength);
-
-		// The maxLength includes the NULL character
-		char* infoLog = new char[maxLength];
-		glGetShaderInfoLog(fragmentShader, maxLength, &maxLength, &infoLog[0]);
-		cout << "Fragment shader failed to compile:" << endl;
-		cout << infoLog;
-		delete[] infoLog;
-		throw new std::runtime_error("Fragment shader failed to compile.");
+unsigned int createProgram(string vertex, string fragment, string geometry) {
+	PendingProgram program = startProgram(vertex, fragment, geometry);
+	return finishProgram(program);
+}
+
+PendingProgram startProgram(string vertex, string fragment, string geometry) {
+	const string vertexSource = getShader(vertex);
+	const string fragmentSource = getShader(fragment);
+	const string geometrySource = geometry.empty() ? "" : getShader(geometry);
+	PendingProgram program;
+
+	// A cached program skips compiling and linking entirely
+	if (ProgramCache::enabled && GLExtensions::getProgramBinary != nullptr) {
+		program.cachePath = getProgramCachePath(vertex, fragment, geometry);
+		program.driver = getDriver();
+		// The attribute bindings below are part of what gets linked, so a change to them must miss the cache too
+		unsigned int sourceHash = MeshCache::checksum(vertexSource.data(), vertexSource.size());
+		sourceHash = MeshCache::checksum(fragmentSource.data(), fragmentSource.size(), sourceHash);
+		sourceHash = MeshCache::checksum(geometrySource.data(), geometrySource.size(), sourceHash);
+		const char bindings[] = "shapeLocation 0, shapeColor 1, shapeNormal 2, shapeEdgeColor 3, instanceColor 4, instanceModel 5";
+		program.sourceHash = MeshCache::checksum(bindings, sizeof(bindings), sourceHash);
+		program.sourceBytes = (unsigned int)(vertexSource.size() + fragmentSource.size() + geometrySource.size());
+		program.id = loadProgramBinary(program.cachePath, program.sourceHash, program.sourceBytes, program.driver);
+		if (program.id != 0) {
+			program.cached = true;
+			return program;
+		}
 	}
+
+	// Create program and shader objects. With parallel shader compiling these return at once, and the driver works
+	// on them until finishProgram() or a completion query needs the result.
+	program.id = glCreateProgram();
+	program.vertexShader = startShader(GL_VERTEX_SHADER, vertexSource);
+	program.fragmentShader = startShader(GL_FRAGMENT_SHADER, fragmentSource);
+	program.geometryShader = geometry.empty() ? 0 : startShader(GL_GEOMETRY_SHADER, geometrySource);
 	// Attach shaders to the program
-	glAttachShader(program, vertexShader);
-	glAttachShader(program, fragmentShader);
-	// Link shaders together
-	glLinkProgram(program);
+	glAttachShader(program.id, program.vertexShader);
+	glAttachShader(program.id, program.fragmentShader);
+	if (program.geometryShader != 0) {
+		glAttachShader(program.id, program.geometryShader);
+	}
+	// Every program gets the same attribute locations, so a VAO set up for one program can draw with any of them.
+	// instanceModel is a mat4 and takes four locations.
+	glBindAttribLocation(program.id, 0, "shapeLocation");
+	glBindAttribLocation(program.id, 1, "shapeColor");
+	glBindAttribLocation(program.id, 2, "shapeNormal");
+	glBindAttribLocation(program.id, 3, "shapeEdgeColor");
+	glBindAttribLocation(program.id, 4, "instanceColor");
+	glBindAttribLocation(program.id, 5, "instanceModel");
+	if (!program.cachePath.empty()) {
+		GLExtensions::programParameteri(program.id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+	// Link shaders together. A shader that failed to compile fails the link, and is reported by finishProgram().
+	glLinkProgram(program.id);
+	return program;
+}
+
+bool isProgramReady(const PendingProgram& program) {
+	if (program.cached || GLExtensions::maxShaderCompilerThreads == nullptr) {
+		return true;
+	}
+	int isComplete = GL_FALSE;
+	glGetProgramiv(program.id, GL_COMPLETION_STATUS_KHR, &isComplete);
+	return isComplete != GL_FALSE;
+}
+
+unsigned int finishProgram(PendingProgram& program) {
+	if (program.cached) {
+		return program.id;
+	}
 	int isLinked = 0;
-	glGetProgramiv(program, GL_LINK_STATUS, &isLinked);
+	glGetProgramiv(program.id, GL_LINK_STATUS, &isLinked);
 	if (isLinked == GL_FALSE)
 	{
-		int maxLength = 0;
-		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &maxLength);
+		// A shader that did not compile explains the failure better than the link log
+		string error = "Could not link program.";
+		if (!checkShader(program.vertexShader, "Vertex")) {
+			error = "Vertex shader failed to compile.";
+		}
+		else if (!checkShader(program.fragmentShader, "Fragment")) {
+			error = "Fragment shader failed to compile.";
+		}
+		else if (!checkShader(program.geometryShader, "Geometry")) {
+			error = "Geometry shader failed to compile.";
+		}
+		else {
+			int maxLength = 0;
+			glGetProgramiv(program.id, GL_INFO_LOG_LENGTH, &maxLength);
 
-		// The maxLength includes the NULL character
-		char* infoLog = new char[maxLength];
-		glGetProgramInfoLog(program, maxLength, &maxLength, &infoLog[0]);
+			// The maxLength includes the NULL character
+			char* infoLog = new char[maxLength];
+			glGetProgramInfoLog(program.id, maxLength, &maxLength, &infoLog[0]);
 
-		// We don't need the program anymore.
-		glDeleteProgram(program);
-		// Don't leak shaders either.
-		glDeleteShader(vertexShader);
-		glDeleteShader(fragmentShader);
+			// Use the infoLog
+			cout << "Could not link program." << endl;
+			cout << infoLog;
+			delete[] infoLog;
+		}
 
-		// Use the infoLog
-		cout << "Could not link program." << endl;
-		cout << infoLog;
+		// Don't leak shaders, or the program.
+		deleteShaders(program);
+		glDeleteProgram(program.id);
+		program.id = 0;
 
-		throw new std::runtime_error("Could not link program.");
+		throw std::runtime_error(error);
 	}
 	// Remove shader objects from program (Shaders are not removed, just the objects used to load them)
-	glDetachShader(program, vertexShader);
-	glDetachShader(program, fragmentShader);
-	// Delete these objects to avoid leaking anything
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
+	deleteShaders(program);
+	if (!program.cachePath.empty()) {
+		saveProgramBinary(program.id, program.cachePath, program.sourceHash, program.sourceBytes, program.driver);
+	}
+	return program.id;
+}
+
+ShaderProgram loadShaderProgram(string vertex, string fragment, string geometry) {
+	PendingProgram program = startProgram(vertex, fragment, geometry);
+	return finishShaderProgram(program);
+}
+
+ShaderProgram finishShaderProgram(PendingProgram& pending) {
+	ShaderProgram program;
+	program.id = finishProgram(pending);
+	program.frameBlock = glGetUniformBlockIndex(program.id, "Frame");
+	if (program.frameBlock != GL_INVALID_INDEX) {
+		glUniformBlockBinding(program.id, program.frameBlock, frameUniformsBinding);
+	}
+	program.shapeLocationAttribute = glGetAttribLocation(program.id, "shapeLocation");
+	program.shapeColorAttribute = glGetAttribLocation(program.id, "shapeColor");
+	program.shapeNormalAttribute = glGetAttribLocation(program.id, "shapeNormal");
+	program.instanceModelAttribute = glGetAttribLocation(program.id, "instanceModel");
+	program.instanceColorAttribute = glGetAttribLocation(program.id, "instanceColor");
+	program.shapeEdgeColorAttribute = glGetAttribLocation(program.id, "shapeEdgeColor");
+	program.firstTriangleUniform = glGetUniformLocation(program.id, "firstTriangle");
+	program.edgeMaskedUniform = glGetUniformLocation(program.id, "edgeMasked");
+	program.wireUniform = glGetUniformLocation(program.id, "wire");
+	// Samplers are fixed to their units here, so drawing only binds textures
+	const int edgeMasks = glGetUniformLocation(program.id, "edgeMasks");
+	if (edgeMasks >= 0) {
+		glUseProgram(program.id);
+		glUniform1i(edgeMasks, edgeMaskTextureUnit);
+		glUseProgram(0);
+	}
 	return program;
 }
 
@@ -106,7 +395,7 @@ void CheckOpenGLError(const char* stmt, const char* fname, int line)
 	if (err != GL_NO_ERROR)
 	{
 		printf("OpenGL error %08x, at %s:%i - for %s\n", err, fname, line, stmt);
-		printf((const char*) gluErrorString(err));
+		printf("%s\n", errorName(err));
 		abort();
 	}
 }
@@ -1,8 +1,5 @@
 #pragma once
 #include <GLAD/glad.h>
-#include <GLFW/glfw3.h>
-#include <windows.h>
-#include <gl/glu.h>
 #include <string>
 using std::string;
 #include <iostream>
@@ -10,14 +7,147 @@ using std::cout; using std::endl;
 #include <fstream>
 using std::ifstream;
 
-/// <summary> Loads a shader from a file and returns it as a string. </summary>
+// Tokens from GL 4.4 / ARB_buffer_storage, which the 3.3 core GLAD header does not define.
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+// Tokens from GL 4.1 / ARB_get_program_binary.
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+// Tokens from KHR_parallel_shader_compile, which ARB_parallel_shader_compile shares.
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+/// <summary> Entry points beyond the 3.3 core profile that GLAD loads. Each is null when the context does not support it. </summary>
+struct GLExtensions {
+	typedef void (APIENTRYP BufferStorageProc)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+	typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+	typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+	typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+	typedef void (APIENTRYP MaxShaderCompilerThreadsProc)(GLuint count);
+
+	/// <summary> glBufferStorage, from GL 4.4 or ARB_buffer_storage. </summary>
+	static BufferStorageProc bufferStorage;
+	/// <summary> glGetProgramBinary, from GL 4.1 or ARB_get_program_binary. Null when the driver offers no binary formats. </summary>
+	static GetProgramBinaryProc getProgramBinary;
+	/// <summary> glProgramBinary, loaded along with getProgramBinary. </summary>
+	static ProgramBinaryProc programBinary;
+	/// <summary> glProgramParameteri, loaded along with getProgramBinary. </summary>
+	static ProgramParameteriProc programParameteri;
+	/// <summary> glMaxShaderCompilerThreadsKHR, from KHR_parallel_shader_compile or ARB_parallel_shader_compile. When set,
+	/// the driver compiles and links on its own threads, and GL_COMPLETION_STATUS_KHR tells whether it is done. </summary>
+	static MaxShaderCompilerThreadsProc maxShaderCompilerThreads;
+};
+
+/// <summary> Loads the optional entry points in GLExtensions. Call once after gladLoadGLLoader(). </summary>
+/// <param name="load"> The function used to look up GL entry points, the same one given to GLAD. </param>
+void loadExtensions(GLADloadproc load);
+
+/// <summary> Checks whether the current context advertises an extension. </summary>
+/// <param name="name"> The extension's name, such as GL_ARB_buffer_storage. </param>
+bool hasExtension(const char* name);
+
+/// <summary> Checks whether the current context is at least GL <paramref name="major"/>.<paramref name="minor"/>. </summary>
+bool hasVersion(const int& major, const int& minor);
+
+/// <summary> Loads a shader from a file and returns it as a string. Throws std::runtime_error if the file cannot be read. </summary>
 /// <param name="path"> The relative path to the shader file. </param>
 string getShader(string path);
 
-/// <summary> Creates a WebGL program from a vertex and a fragment shader. </summary>
+/// <summary> Where createProgram() keeps linked programs between runs, so later launches skip compiling and linking.
+/// Each program is stored in its own file, stamped with a hash of its sources and the driver that built it; a file
+/// from other sources or another driver is ignored and rewritten. </summary>
+struct ProgramCache {
+	/// <summary> Whether to read and write cached programs. Can be modified directly. </summary>
+	static bool enabled;
+	/// <summary> Put in front of each cache file's name, such as a directory ending in a slash. Empty uses the working
+	/// directory. Can be modified directly. </summary>
+	static string prefix;
+};
+
+/// <summary> Creates a WebGL program from a vertex, a fragment and optionally a geometry shader, or loads it from the
+/// ProgramCache. Throws std::runtime_error if a shader cannot be read or compiled, or the program cannot be linked. </summary>
 /// <param name="vertex"> The relative path to the vertex shader file. </param>
 /// <param name="fragment"> The relative path to the fragment shader file. </param>
-unsigned int createProgram(string vertex, string fragment);
+/// <param name="geometry"> The relative path to the geometry shader file, or empty for none. </param>
+unsigned int createProgram(string vertex, string fragment, string geometry = "");
+
+/// <summary> A program handed to the driver by startProgram(), which may still be compiling. Only finishProgram() should
+/// read or change it. </summary>
+struct PendingProgram {
+	/// <summary> The program, or 0 if none has been started. </summary>
+	unsigned int id = 0;
+	unsigned int vertexShader = 0;
+	unsigned int fragmentShader = 0;
+	unsigned int geometryShader = 0;
+	/// <summary> Whether the program came from the ProgramCache, already linked. </summary>
+	bool cached = false;
+	/// <summary> The file to save the linked program to, or empty to not save it. </summary>
+	string cachePath;
+	string driver;
+	unsigned int sourceHash = 0;
+	unsigned int sourceBytes = 0;
+};
+
+/// <summary> The first half of createProgram(): reads the shaders and starts compiling and linking them, or loads the
+/// program from the ProgramCache, without waiting for the driver to finish. Throws std::runtime_error if a shader cannot be read. </summary>
+/// <param name="vertex"> The relative path to the vertex shader file. </param>
+/// <param name="fragment"> The relative path to the fragment shader file. </param>
+/// <param name="geometry"> The relative path to the geometry shader file, or empty for none. </param>
+PendingProgram startProgram(string vertex, string fragment, string geometry = "");
+
+/// <summary> Checks whether finishProgram() can return without waiting for the driver. Without parallel shader compiling
+/// there is no way to tell, so this is always true and finishProgram() waits. </summary>
+bool isProgramReady(const PendingProgram& program);
+
+/// <summary> The second half of createProgram(): waits for a started program if it is not ready, frees its shaders and
+/// saves it to the ProgramCache. Throws std::runtime_error if a shader did not compile or the program did not link. </summary>
+/// <returns> The linked program. </returns>
+unsigned int finishProgram(PendingProgram& program);
+
+/// <summary> The uniform buffer binding point of the per-frame Frame block. See FrameUniforms. </summary>
+static const unsigned int frameUniformsBinding = 0;
+
+/// <summary> The texture unit programs read their edgeMasks buffer texture from. See GraphicsShape. </summary>
+static const int edgeMaskTextureUnit = 0;
+
+/// <summary> A linked program, along with the locations of the uniforms and attributes the renderer uses.
+/// Locations are looked up once at link time, so drawing never has to query them. A location is -1 if the
+/// program does not use it. </summary>
+struct ShaderProgram {
+	unsigned int id = 0;
+	unsigned int frameBlock = GL_INVALID_INDEX;
+	int shapeLocationAttribute = -1;
+	int shapeColorAttribute = -1;
+	int shapeNormalAttribute = -1;
+	int instanceModelAttribute = -1;
+	int instanceColorAttribute = -1;
+	int shapeEdgeColorAttribute = -1;
+	int firstTriangleUniform = -1;
+	int edgeMaskedUniform = -1;
+	int wireUniform = -1;
+};
+
+/// <summary> Creates a program with createProgram(), caches its uniform and attribute locations, and attaches
+/// its Frame block to frameUniformsBinding and its edgeMasks sampler to edgeMaskTextureUnit. </summary>
+/// <param name="vertex"> The relative path to the vertex shader file. </param>
+/// <param name="fragment"> The relative path to the fragment shader file. </param>
+/// <param name="geometry"> The relative path to the geometry shader file, or empty for none. </param>
+ShaderProgram loadShaderProgram(string vertex, string fragment, string geometry = "");
+
+/// <summary> Finishes a program with finishProgram() and sets it up like loadShaderProgram(). </summary>
+ShaderProgram finishShaderProgram(PendingProgram& program);
 
 void CheckOpenGLError(const char* stmt, const char* fname, int line);
 